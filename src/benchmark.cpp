@@ -0,0 +1,1862 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include "rules.h"
+#include "lockstep.h"
+#include "environment.h"
+#include "mcts.h"
+#include "zobrist.h"
+#include "transposition.h"
+#include "canonical.h"
+#include "solver.h"
+#include "generator.h"
+#include "refill.h"
+#include "snapshot.h"
+#include "bordered.h"
+#include "columns.h"
+#include "lines.h"
+#include "tweens.h"
+#include "visuals.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+static double get_seconds() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    return std::chrono::duration<double>(now).count();
+}
+
+const auto rollout_length = 30;
+const auto rollout_board_count = 1 << 15;
+
+static void report(const char *name, double seconds, long long count, const char *unit = "moves") {
+    printf("%-32s %10.3f ms %14.0f %s/s\n", name, seconds * 1000, count / seconds, unit);
+}
+
+static void benchmark_scalar_rollouts() {
+    Random moves_random;
+    seed_random(&moves_random, 1);
+
+    long long total_points = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto board = 0; board < rollout_board_count; board += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)board + 1);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            total_points += simulate_swap(tiles, &random, (int)(next_random(&moves_random) % swap_count));
+        }
+    }
+
+    report("scalar rollouts", get_seconds() - start_time, (long long)rollout_board_count * rollout_length);
+
+    printf("    total points %lld\n", total_points);
+}
+
+static void benchmark_bordered_rollouts() {
+    Random moves_random;
+    seed_random(&moves_random, 1);
+
+    long long total_points = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto board = 0; board < rollout_board_count; board += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)board + 1);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        BorderedTiles bordered;
+        bordered_load(&bordered, tiles);
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            total_points += bordered_simulate_swap(&bordered, &random, (int)(next_random(&moves_random) % swap_count));
+        }
+    }
+
+    report("bordered rollouts", get_seconds() - start_time, (long long)rollout_board_count * rollout_length);
+
+    printf("    total points %lld\n", total_points);
+}
+
+// Both layouts must agree on every swap, with and without refill
+static bool check_bordered_matches_scalar() {
+    Random random;
+    seed_random(&random, 16);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        BorderedTiles bordered;
+        bordered_load(&bordered, tiles);
+
+        auto refill = board % 2 == 0;
+
+        Random scalar_random = random;
+        Random bordered_random = random;
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            int scoring_swaps[swap_count];
+            int bordered_scoring_swaps[swap_count];
+
+            auto scoring_count = find_scoring_swaps(tiles, scoring_swaps);
+
+            if(
+                bordered_find_scoring_swaps(&bordered, bordered_scoring_swaps) != scoring_count ||
+                memcmp(scoring_swaps, bordered_scoring_swaps, scoring_count * sizeof(int)) != 0
+            ) {
+                return false;
+            }
+
+            auto swap_index = (int)(next_random(&random) % swap_count);
+
+            auto points = simulate_swap(tiles, refill ? &scalar_random : nullptr, swap_index);
+            auto bordered_points = bordered_simulate_swap(&bordered, refill ? &bordered_random : nullptr, swap_index);
+
+            Tile bordered_tiles[playfield_size][playfield_size];
+            bordered_store(&bordered, bordered_tiles);
+
+            if(points != bordered_points || memcmp(tiles, bordered_tiles, sizeof(tiles)) != 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_move_generators() {
+    const auto board_count = 1 << 14;
+
+    Random random;
+    seed_random(&random, 17);
+
+    auto boards = (Tile(*)[playfield_size][playfield_size])malloc(board_count * sizeof(Tile[playfield_size][playfield_size]));
+    auto bordered_boards = (BorderedTiles*)malloc(board_count * sizeof(BorderedTiles));
+
+    for(auto i = 0; i < board_count; i += 1) {
+        fill_random_tiles(boards[i], &random);
+        bordered_load(&bordered_boards[i], boards[i]);
+    }
+
+    long long scoring_count = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        int scoring_swaps[swap_count];
+        scoring_count += find_scoring_swaps(boards[i], scoring_swaps);
+    }
+
+    report("move generator", get_seconds() - start_time, board_count, "boards");
+
+    start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        int scoring_swaps[swap_count];
+        scoring_count -= bordered_find_scoring_swaps(&bordered_boards[i], scoring_swaps);
+    }
+
+    report("bordered move generator", get_seconds() - start_time, board_count, "boards");
+
+    printf("    difference in scoring swaps %lld\n", scoring_count);
+
+    free(bordered_boards);
+    free(boards);
+}
+
+static void benchmark_column_rollouts() {
+    Random moves_random;
+    seed_random(&moves_random, 1);
+
+    long long total_points = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto board = 0; board < rollout_board_count; board += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)board + 1);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        ColumnTiles columns;
+        column_load(&columns, tiles);
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            total_points += column_simulate_swap(&columns, &random, (int)(next_random(&moves_random) % swap_count));
+        }
+    }
+
+    report("column-major rollouts", get_seconds() - start_time, (long long)rollout_board_count * rollout_length);
+
+    printf("    total points %lld\n", total_points);
+}
+
+static bool check_columns_match_scalar() {
+    Random random;
+    seed_random(&random, 18);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        ColumnTiles columns;
+        column_load(&columns, tiles);
+
+        auto refill = board % 2 == 0;
+
+        Random scalar_random = random;
+        Random column_random = random;
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            auto swap_index = (int)(next_random(&random) % swap_count);
+
+            auto points = simulate_swap(tiles, refill ? &scalar_random : nullptr, swap_index);
+            auto column_points = column_simulate_swap(&columns, refill ? &column_random : nullptr, swap_index);
+
+            Tile column_tiles[playfield_size][playfield_size];
+            column_store(&columns, column_tiles);
+
+            if(points != column_points || memcmp(tiles, column_tiles, sizeof(tiles)) != 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Both rules through the same entry point, so the difference is only in what clears
+static void benchmark_rule_rollouts(const char *name, MatchRule rule) {
+    Random moves_random;
+    seed_random(&moves_random, 1);
+
+    long long total_points = 0;
+    long long scoring_count = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto board = 0; board < rollout_board_count; board += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)board + 1);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            auto points = simulate_rule_swap(rule, tiles, &random, (int)(next_random(&moves_random) % swap_count));
+
+            total_points += points;
+            scoring_count += points > 0 ? 1 : 0;
+        }
+    }
+
+    report(name, get_seconds() - start_time, (long long)rollout_board_count * rollout_length);
+
+    printf("    total points %lld, scoring swaps %lld\n", total_points, scoring_count);
+}
+
+static bool check_runs_match_scalar() {
+    Random random;
+    seed_random(&random, 41);
+
+    for(auto board = 0; board < 1 << 12; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        // Gaps as well, which never belong to a run
+        for(auto i = 0; i < 10; i += 1) {
+            tiles[next_random(&random) % playfield_size][next_random(&random) % playfield_size] = 0;
+        }
+
+        uint16_t runs[playfield_size];
+        find_runs(tiles, runs);
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if((((runs[y] >> x) & 1) != 0) != in_run(tiles, x, y)) {
+                    printf("run detector differs from scalar on board %d at %d %d\n", board, x, y);
+
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_run_detection() {
+    const auto board_count = 1 << 14;
+    const auto repeat_count = 16;
+
+    Random random;
+    seed_random(&random, 43);
+
+    auto boards = (Tile(*)[playfield_size][playfield_size])malloc(board_count * sizeof(Tile[playfield_size][playfield_size]));
+
+    for(auto i = 0; i < board_count; i += 1) {
+        fill_random_tiles(boards[i], &random);
+    }
+
+    long long run_count = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto repeat = 0; repeat < repeat_count; repeat += 1) {
+        for(auto i = 0; i < board_count; i += 1) {
+            uint16_t runs[playfield_size];
+            find_runs(boards[i], runs);
+
+            for(auto y = 0; y < playfield_size; y += 1) {
+                for(auto bits = runs[y]; bits != 0; bits &= bits - 1) {
+                    run_count += 1;
+                }
+            }
+        }
+    }
+
+    report("run detection", get_seconds() - start_time, (long long)board_count * repeat_count, "boards");
+
+    start_time = get_seconds();
+
+    for(auto repeat = 0; repeat < repeat_count; repeat += 1) {
+        for(auto i = 0; i < board_count; i += 1) {
+            for(auto y = 0; y < playfield_size; y += 1) {
+                for(auto x = 0; x < playfield_size; x += 1) {
+                    run_count -= in_run(boards[i], x, y) ? 1 : 0;
+                }
+            }
+        }
+    }
+
+    report("run detection per tile", get_seconds() - start_time, (long long)board_count * repeat_count, "boards");
+
+    printf("    difference in run tiles %lld\n", run_count);
+
+    long long scoring_count = 0;
+
+    start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        int scoring_swaps[swap_count];
+        scoring_count += find_line_scoring_swaps(boards[i], scoring_swaps);
+    }
+
+    report("line move generator", get_seconds() - start_time, board_count, "boards");
+
+    printf("    scoring swaps per board %.1f\n", (double)scoring_count / board_count);
+
+    free(boards);
+}
+
+// A points ticker and a falling tile are advanced at several frame rates, including uneven
+// uncapped frames, and must each finish within one frame of when they would with exact timing
+static bool check_animation_rates() {
+    const auto tick_time = 0.05;
+    const auto target_points = 37;
+    const auto fall_height = 9;
+
+    auto exact_ticker_time = target_points * tick_time;
+    auto exact_landing_time = sqrt(2 * fall_height / fall_acceleration);
+
+    double frame_times[] = { 1.0 / 30, 1.0 / 60, 1.0 / 144, 1.0 / 240, 0 };
+
+    Random random;
+    seed_random(&random, 47);
+
+    for(auto frame_time : frame_times) {
+        Tweens tweens;
+        tweens_init(&tweens, 16, 0);
+
+        auto ticker = tween_add(&tweens, 0, target_points * tick_time, 0, target_points, Easing::Linear);
+        auto fall = tween_add(&tweens, 0, fall_duration(fall_height), 0, fall_height, Easing::EaseIn);
+
+        auto ticker_time = -1.0;
+        auto landing_time = -1.0;
+
+        auto time = 0.0;
+        auto longest_frame = frame_time;
+
+        while(ticker_time < 0 || landing_time < 0) {
+            auto delta_time = frame_time;
+
+            // Uncapped frames take anywhere from 1 to 11 ms
+            if(delta_time == 0) {
+                delta_time = 0.001 + (next_random(&random) % 1000) * 0.00001;
+
+                if(delta_time > longest_frame) {
+                    longest_frame = delta_time;
+                }
+            }
+
+            time += delta_time;
+
+            tweens_advance(&tweens, time);
+
+            if(ticker_time < 0 && (int)tween_value(&tweens, ticker) == target_points) {
+                ticker_time = time;
+            }
+
+            if(landing_time < 0 && tween_done(&tweens, fall)) {
+                landing_time = time;
+            }
+        }
+
+        tweens_free(&tweens);
+
+        auto ticker_error = ticker_time - exact_ticker_time;
+        auto landing_error = landing_time - exact_landing_time;
+
+        if(ticker_error < -1e-4 || ticker_error > longest_frame + 1e-4 || landing_error < -1e-4 || landing_error > longest_frame + 1e-4) {
+            printf("animations at %.4f s frames end %.4f s and %.4f s off\n", frame_time, ticker_error, landing_error);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Values cross from a producer thread to the consumer in the order they were pushed, none lost
+// or repeated, through a queue small enough to fill up over and over
+static bool check_spsc_order() {
+    const auto value_count = 20000;
+
+    auto queue = new SpscQueue<int, 64>;
+    spsc_init(queue);
+
+    std::thread producer([queue]() {
+        for(auto i = 0; i < value_count; i += 1) {
+            while(!spsc_push(queue, i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    auto in_order = true;
+
+    for(auto expected = 0; expected < value_count; expected += 1) {
+        int value;
+        while(!spsc_pop(queue, &value)) {
+            std::this_thread::yield();
+        }
+
+        in_order = in_order && value == expected;
+    }
+
+    producer.join();
+
+    int extra;
+    in_order = in_order && !spsc_pop(queue, &extra);
+
+    delete queue;
+
+    return in_order;
+}
+
+// The reader always gets the newest published value, and never the slot being written
+static bool check_triple_buffer() {
+    TripleBuffer<int> buffer;
+    triple_buffer_init(&buffer);
+
+    auto valid = true;
+
+    for(auto i = 1; i <= 10; i += 1) {
+        *triple_buffer_back(&buffer) = i;
+        triple_buffer_publish(&buffer);
+
+        // Every other value is published over before the reader looks
+        if(i % 2 == 1) {
+            continue;
+        }
+
+        auto front = triple_buffer_front(&buffer);
+
+        valid = valid && *front == i && front != triple_buffer_back(&buffer);
+
+        // Reading again without a new value keeps the same one
+        valid = valid && triple_buffer_front(&buffer) == front;
+    }
+
+    return valid;
+}
+
+// Tweens added hours into a game must still time to well under a millisecond
+static bool check_tween_precision() {
+    Tweens tweens;
+    tweens_init(&tweens, 4, 0);
+
+    auto valid = true;
+
+    for(auto hours = 1; hours <= 64; hours *= 4) {
+        auto time = hours * 3600.0;
+
+        tweens_advance(&tweens, time);
+
+        auto tween = tween_add(&tweens, time + 0.5, 0.002, 0, 1, Easing::Linear);
+
+        tweens_advance(&tweens, time + 0.501);
+
+        valid = valid && fabs(tween_value(&tweens, tween) - 0.5) < 0.01;
+        valid = valid && fabs(tween_end_time(&tweens, tween) - (time + 0.502)) < 1e-5;
+
+        tween_release(&tweens, tween);
+    }
+
+    tweens_free(&tweens);
+
+    return valid;
+}
+
+static void benchmark_tweens() {
+    const auto tween_count = 4096;
+    const auto frame_count = 10000;
+
+    Tweens tweens;
+    tweens_init(&tweens, tween_count, 0);
+
+    Random random;
+    seed_random(&random, 53);
+
+    for(auto i = 0; i < tween_count; i += 1) {
+        auto start_time = (next_random(&random) % 1000) * 0.001;
+        auto duration = 0.1 + (next_random(&random) % 1000) * 0.001;
+
+        tween_add(&tweens, start_time, duration, 0, (float)(next_random(&random) % 100), (Easing)(i % 4));
+    }
+
+    auto total = 0.0;
+
+    auto start_time = get_seconds();
+
+    for(auto frame = 0; frame < frame_count; frame += 1) {
+        tweens_advance(&tweens, frame * (1.0 / 240));
+
+        total += tweens.values[frame % tween_count];
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("advance 4096 tweens", seconds, frame_count, "frames");
+
+    printf("    %.1f us per frame (%.0f)\n", seconds / frame_count * 1e6, total);
+
+    tweens_free(&tweens);
+}
+
+static Entity add_test_particle(Visuals *visuals, Tweens *tweens, Random *random, double time) {
+    auto entity = visual_create(visuals);
+
+    auto duration = 0.1 + (next_random(random) % 1000) * 0.001;
+
+    Placement placement { 0, 0, 1, -1, -1, -1, true, false };
+    placement.x_tween = tween_add(tweens, time, duration, 0, (float)(next_random(random) % 10), Easing::Linear);
+    placement.y_tween = tween_add(tweens, time, duration, 0, (float)(next_random(random) % 10), Easing::Linear);
+
+    component_set(&visuals->placements, entity, placement);
+    component_set(&visuals->appearances, entity, { VisualShape::Particle, 1, 0 });
+    component_set(&visuals->lifetimes, entity, { placement.x_tween });
+
+    return entity;
+}
+
+// Handles to destroyed entities must go stale even once their index is taken again, and every
+// component must stay packed and pointing at its owner
+static bool check_visual_handles() {
+    const auto entity_count = 64;
+
+    Tweens tweens;
+    tweens_init(&tweens, entity_count * 2, 0);
+
+    Visuals visuals;
+    visuals_init(&visuals, entity_count);
+
+    Random random;
+    seed_random(&random, 59);
+
+    Entity entities[entity_count];
+
+    for(auto i = 0; i < entity_count; i += 1) {
+        entities[i] = add_test_particle(&visuals, &tweens, &random, 0);
+    }
+
+    auto valid = visual_create(&visuals).index == -1;
+
+    for(auto i = 0; i < entity_count; i += 3) {
+        visual_destroy(&visuals, &tweens, entities[i]);
+    }
+
+    for(auto i = 0; i < entity_count; i += 3) {
+        auto entity = add_test_particle(&visuals, &tweens, &random, 0);
+
+        valid = valid && entity.index != -1 && !visual_alive(&visuals, entities[i]);
+
+        // Destroying through a stale handle must leave the new entity be
+        visual_destroy(&visuals, &tweens, entities[i]);
+
+        valid = valid && visual_alive(&visuals, entity);
+    }
+
+    for(auto i = 0; i < visuals.placements.count; i += 1) {
+        auto owner = visuals.placements.owners[i];
+
+        valid = valid && visuals.placements.slots[owner] == i && visuals.lifetimes.slots[owner] != -1;
+    }
+
+    // Once every lifetime is up, nothing is left, tweens included
+    tweens_advance(&tweens, 10);
+    expire_visuals(&visuals, &tweens);
+
+    valid = valid && visuals.placements.count == 0 && visuals.appearances.count == 0 && visuals.lifetimes.count == 0;
+    valid = valid && (int)tweens.free_slots.count == tweens.slot_count;
+
+    visuals_free(&visuals);
+    tweens_free(&tweens);
+
+    return valid;
+}
+
+// A burst of particles kept topped up, each frame advancing, expiring and placing all of them
+static void benchmark_visuals() {
+    const auto entity_count = 4096;
+    const auto frame_count = 10000;
+
+    Tweens tweens;
+    tweens_init(&tweens, entity_count * 2, 0);
+
+    Visuals visuals;
+    visuals_init(&visuals, entity_count);
+
+    Random random;
+    seed_random(&random, 61);
+
+    for(auto i = 0; i < entity_count; i += 1) {
+        add_test_particle(&visuals, &tweens, &random, 0);
+    }
+
+    auto total = 0.0;
+    long long spawned = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto frame = 0; frame < frame_count; frame += 1) {
+        auto time = frame * (1.0 / 240);
+
+        tweens_advance(&tweens, time);
+        expire_visuals(&visuals, &tweens);
+        place_visuals(&visuals, &tweens);
+
+        while(visuals.lifetimes.count < entity_count) {
+            add_test_particle(&visuals, &tweens, &random, time);
+
+            spawned += 1;
+        }
+
+        total += visuals.placements.values[frame % visuals.placements.count].x;
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("4096 visual entities", seconds, frame_count, "frames");
+
+    printf("    %.1f us per frame, %lld spawned (%.0f)\n", seconds / frame_count * 1e6, spawned, total);
+
+    visuals_free(&visuals);
+    tweens_free(&tweens);
+}
+
+// Gravity alone, on boards with about a fifth of their tiles cleared
+static void benchmark_gravity() {
+    const auto board_count = 1 << 12;
+    const auto round_count = 64;
+
+    Random random;
+    seed_random(&random, 19);
+
+    auto boards = (Tile(*)[playfield_size][playfield_size])malloc(board_count * sizeof(Tile[playfield_size][playfield_size]));
+    auto column_boards = (ColumnTiles*)malloc(board_count * sizeof(ColumnTiles));
+
+    for(auto i = 0; i < board_count; i += 1) {
+        fill_random_tiles(boards[i], &random);
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(next_random(&random) % 5 == 0) {
+                    boards[i][y][x] = 0;
+                }
+            }
+        }
+
+        column_load(&column_boards[i], boards[i]);
+    }
+
+    long long checksum = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto round = 0; round < round_count; round += 1) {
+        for(auto i = 0; i < board_count; i += 1) {
+            Tile tiles[playfield_size][playfield_size];
+            memcpy(tiles, boards[i], sizeof(tiles));
+
+            settle_tiles(tiles, nullptr);
+
+            checksum += tiles[playfield_size - 1][round % playfield_size];
+        }
+    }
+
+    report("row-major gravity", get_seconds() - start_time, (long long)board_count * round_count, "boards");
+
+    start_time = get_seconds();
+
+    for(auto round = 0; round < round_count; round += 1) {
+        for(auto i = 0; i < board_count; i += 1) {
+            ColumnTiles columns = column_boards[i];
+
+            column_settle(&columns, nullptr);
+
+            checksum -= columns.cells[column_index(round % playfield_size, playfield_size - 1)];
+        }
+    }
+
+    report("column-major gravity", get_seconds() - start_time, (long long)board_count * round_count, "boards");
+
+    printf("    difference in bottom tiles %lld\n", checksum);
+
+    free(column_boards);
+    free(boards);
+}
+
+// Greedy games where refill_tiles runs as its own stage after each settle, counting the moves
+// each refilled board leaves
+template <typename Policy>
+static void benchmark_refill(const char *name, Policy *policy, Random *random) {
+    const auto game_count = 2000;
+
+    long long move_count = 0;
+    long long scoring_count = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto game = 0; game < game_count; game += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, random);
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            auto best_swap = -1;
+            auto best_points = 0;
+
+            for(auto i = 0; i < swap_count; i += 1) {
+                auto points = swap_points(tiles, i);
+
+                if(points > best_points) {
+                    best_swap = i;
+                    best_points = points;
+                }
+            }
+
+            if(best_swap == -1) {
+                break;
+            }
+
+            simulate_swap(tiles, policy, best_swap);
+
+            int scoring_swaps[swap_count];
+            scoring_count += find_scoring_swaps(tiles, scoring_swaps);
+
+            move_count += 1;
+        }
+    }
+
+    report(name, get_seconds() - start_time, move_count);
+
+    printf("    %.1f scoring swaps after each refill\n", (double)scoring_count / move_count);
+}
+
+// Plays the same greedy game twice with each policy: both must draw the same kinds, so games and
+// searches can be replayed. Uniform refill must also draw as random_tile_kind would, top down.
+template <typename Policy>
+static bool check_refill_repeats(Policy first, Policy second) {
+    Random random;
+    seed_random(&random, 16);
+
+    Tile first_tiles[playfield_size][playfield_size];
+    fill_random_tiles(first_tiles, &random);
+
+    Tile second_tiles[playfield_size][playfield_size];
+    memcpy(second_tiles, first_tiles, sizeof(second_tiles));
+
+    for(auto move = 0; move < rollout_length; move += 1) {
+        int scoring_swaps[swap_count];
+        auto scoring_count = find_scoring_swaps(first_tiles, scoring_swaps);
+
+        if(scoring_count == 0) {
+            break;
+        }
+
+        auto swap_index = scoring_swaps[move % scoring_count];
+
+        simulate_swap(first_tiles, &first, swap_index);
+        simulate_swap(second_tiles, &second, swap_index);
+
+        if(memcmp(first_tiles, second_tiles, sizeof(first_tiles)) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_refill_policies() {
+    Random first_random;
+    Random second_random;
+    seed_random(&first_random, 17);
+    seed_random(&second_random, 17);
+
+    if(!check_refill_repeats(UniformRefill { &first_random }, UniformRefill { &second_random })) {
+        return false;
+    }
+
+    if(!check_refill_repeats(AntiDeadlockRefill { &first_random }, AntiDeadlockRefill { &second_random })) {
+        return false;
+    }
+
+    const int script[] { 1, 2, 3, 4, 5, 6, 1, 3, 5, 2, 4, 6 };
+    const auto script_length = (int)(sizeof(script) / sizeof(script[0]));
+
+    if(!check_refill_repeats(ScriptedRefill { script, script_length, 0 }, ScriptedRefill { script, script_length, 0 })) {
+        return false;
+    }
+
+    // A board with the top two rows cleared refills column by column, top down
+    Tile tiles[playfield_size][playfield_size];
+    fill_random_tiles(tiles, &first_random);
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        tiles[0][x] = 0;
+        tiles[1][x] = 0;
+    }
+
+    auto expected_random = first_random;
+
+    UniformRefill uniform { &first_random };
+    refill_tiles(tiles, &uniform);
+
+    ScriptedRefill scripted { script, script_length, 0 };
+
+    Tile scripted_tiles[playfield_size][playfield_size];
+    memcpy(scripted_tiles, tiles, sizeof(tiles));
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        scripted_tiles[0][x] = 0;
+        scripted_tiles[1][x] = 0;
+    }
+
+    refill_tiles(scripted_tiles, &scripted);
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        for(auto y = 0; y < 2; y += 1) {
+            if(tiles[y][x] != random_tile_kind(&expected_random)) {
+                return false;
+            }
+
+            if(scripted_tiles[y][x] != script[(x * 2 + y) % script_length]) {
+                return false;
+            }
+        }
+    }
+
+    return first_random.state == expected_random.state;
+}
+
+static void benchmark_refill_policies() {
+    Random random;
+    seed_random(&random, 12);
+
+    Random refill_random;
+    seed_random(&refill_random, 13);
+
+    UniformRefill uniform { &refill_random };
+    benchmark_refill("greedy with uniform refill", &uniform, &random);
+
+    AntiDeadlockRefill anti_deadlock { &refill_random };
+    benchmark_refill("greedy with anti-deadlock refill", &anti_deadlock, &random);
+
+    const int script[] { 1, 2, 3, 4, 5, 6, 1, 3, 5, 2, 4, 6 };
+    ScriptedRefill scripted { script, (int)(sizeof(script) / sizeof(script[0])), 0 };
+    benchmark_refill("greedy with scripted refill", &scripted, &random);
+}
+
+static void benchmark_lockstep_rollouts() {
+    Random moves_random;
+    seed_random(&moves_random, 1);
+
+    long long total_points = 0;
+
+    auto boards = (LockstepBoards*)malloc(sizeof(LockstepBoards));
+
+    auto start_time = get_seconds();
+
+    for(auto first_board = 0; first_board < rollout_board_count; first_board += lockstep_lane_count) {
+        for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+            Random random;
+            seed_random(&random, (uint32_t)(first_board + lane) + 1);
+
+            Tile tiles[playfield_size][playfield_size];
+            fill_random_tiles(tiles, &random);
+
+            lockstep_load(boards, lane, tiles, random);
+        }
+
+        for(auto move = 0; move < rollout_length; move += 1) {
+            int swap_indices[lockstep_lane_count];
+            for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+                swap_indices[lane] = (int)(next_random(&moves_random) % swap_count);
+            }
+
+            lockstep_simulate_swaps(boards, swap_indices);
+        }
+
+        for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+            total_points += boards->points[lane];
+        }
+    }
+
+    report("lockstep rollouts", get_seconds() - start_time, (long long)rollout_board_count * rollout_length);
+
+    printf("    total points %lld\n", total_points);
+
+    free(boards);
+}
+
+// The lockstep engine must stay move-for-move identical to the scalar rules
+static bool check_lockstep_matches_scalar() {
+    auto boards = (LockstepBoards*)malloc(sizeof(LockstepBoards));
+
+    Tile tiles[lockstep_lane_count][playfield_size][playfield_size];
+    Random randoms[lockstep_lane_count];
+    int points[lockstep_lane_count] {};
+
+    for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+        seed_random(&randoms[lane], (uint32_t)lane + 100);
+        fill_random_tiles(tiles[lane], &randoms[lane]);
+
+        lockstep_load(boards, lane, tiles[lane], randoms[lane]);
+    }
+
+    Random moves_random;
+    seed_random(&moves_random, 2);
+
+    auto matches = true;
+
+    for(auto move = 0; move < 1000 && matches; move += 1) {
+        int swap_indices[lockstep_lane_count];
+        for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+            swap_indices[lane] = (int)(next_random(&moves_random) % swap_count);
+
+            points[lane] += simulate_swap(tiles[lane], &randoms[lane], swap_indices[lane]);
+        }
+
+        lockstep_simulate_swaps(boards, swap_indices);
+
+        for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+            Tile lane_tiles[playfield_size][playfield_size];
+            Random lane_random;
+            lockstep_store(boards, lane, lane_tiles, &lane_random);
+
+            for(auto y = 0; y < playfield_size; y += 1) {
+                for(auto x = 0; x < playfield_size; x += 1) {
+                    if(lane_tiles[y][x] != tiles[lane][y][x]) {
+                        matches = false;
+                    }
+                }
+            }
+
+            if(lane_random.state != randoms[lane].state || boards->points[lane] != points[lane]) {
+                matches = false;
+            }
+        }
+    }
+
+    free(boards);
+
+    return matches;
+}
+
+static bool check_move_generator_matches_scalar() {
+    Random random;
+    seed_random(&random, 3);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        for(auto i = 0; i < swap_count; i += 1) {
+            Tile swapped_tiles[playfield_size][playfield_size];
+            memcpy(swapped_tiles, tiles, sizeof(tiles));
+
+            Random swap_random = random;
+
+            if(swap_scores(tiles, i) != (simulate_swap(swapped_tiles, &swap_random, i) != 0)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool check_potential_groups() {
+    Random random;
+    seed_random(&random, 8);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        int scoring_swaps[swap_count];
+        auto scoring_count = find_scoring_swaps(tiles, scoring_swaps);
+
+        bool potential[playfield_size][playfield_size];
+        mark_potential_groups(tiles, scoring_swaps, scoring_count, potential);
+
+        bool expected[playfield_size][playfield_size] {};
+
+        for(auto i = 0; i < swap_count; i += 1) {
+            int from_x;
+            int from_y;
+            int to_x;
+            int to_y;
+            swap_from_index(i, &from_x, &from_y, &to_x, &to_y);
+
+            Tile swapped_tiles[playfield_size][playfield_size];
+            memcpy(swapped_tiles, tiles, sizeof(tiles));
+
+            swapped_tiles[from_y][from_x] = tiles[to_y][to_x];
+            swapped_tiles[to_y][to_x] = tiles[from_y][from_x];
+
+            bool to_group[playfield_size][playfield_size] {};
+            bool from_group[playfield_size][playfield_size] {};
+
+            auto to_count = count_neighbours(swapped_tiles, to_group, to_x, to_y, swapped_tiles[to_y][to_x]);
+            auto from_count = count_neighbours(swapped_tiles, from_group, from_x, from_y, swapped_tiles[from_y][from_x]);
+
+            for(auto y = 0; y < playfield_size; y += 1) {
+                for(auto x = 0; x < playfield_size; x += 1) {
+                    if(!((to_count >= 3 && to_group[y][x]) || (from_count >= 3 && from_group[y][x]))) {
+                        continue;
+                    }
+
+                    if(x == from_x && y == from_y) {
+                        expected[to_y][to_x] = true;
+                    } else if(x == to_x && y == to_y) {
+                        expected[from_y][from_x] = true;
+                    } else {
+                        expected[y][x] = true;
+                    }
+                }
+            }
+        }
+
+        if(memcmp(potential, expected, sizeof(expected)) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_potential_groups() {
+    const auto board_count = 1 << 14;
+
+    Random random;
+    seed_random(&random, 9);
+
+    auto boards = (Tile(*)[playfield_size][playfield_size])malloc(board_count * sizeof(Tile[playfield_size][playfield_size]));
+
+    for(auto i = 0; i < board_count; i += 1) {
+        fill_random_tiles(boards[i], &random);
+    }
+
+    long long marked = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        int scoring_swaps[swap_count];
+        auto scoring_count = find_scoring_swaps(boards[i], scoring_swaps);
+
+        bool potential[playfield_size][playfield_size];
+        mark_potential_groups(boards[i], scoring_swaps, scoring_count, potential);
+
+        marked += potential[i % playfield_size][i / playfield_size % playfield_size];
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("potential groups", seconds, board_count, "boards");
+
+    printf("    %.0f ns per board (%lld sampled tiles marked)\n", seconds * 1e9 / board_count, marked);
+
+    free(boards);
+}
+
+const auto generated_move_count = 5;
+
+static bool check_generated_boards() {
+    Random random;
+    seed_random(&random, 10);
+
+    for(auto board = 0; board < 10000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        auto planted = generate_tiles(tiles, &random, generated_move_count);
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(tiles[y][x] == 0 || in_group(tiles, x, y)) {
+                    return false;
+                }
+            }
+        }
+
+        int scoring_swaps[swap_count];
+        if(planted < generated_move_count || find_scoring_swaps(tiles, scoring_swaps) < generated_move_count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_generator() {
+    const auto board_count = 1 << 18;
+
+    Random random;
+    seed_random(&random, 11);
+
+    auto start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        generate_tiles(tiles, &random, generated_move_count);
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("generate boards", seconds, board_count, "boards");
+
+    long long scoring_count = 0;
+
+    for(auto i = 0; i < 1000; i += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        generate_tiles(tiles, &random, generated_move_count);
+
+        int scoring_swaps[swap_count];
+        scoring_count += find_scoring_swaps(tiles, scoring_swaps);
+    }
+
+    printf("    %.1f million boards per minute, %.1f scoring swaps on average\n", board_count / seconds * 60 / 1e6, scoring_count / 1000.0);
+}
+
+static bool check_snapshots() {
+    Random random;
+    seed_random(&random, 14);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        // Some empty tiles as well, as left by settling without refill
+        tiles[board % playfield_size][board / playfield_size % playfield_size] = 0;
+
+        BoardSnapshot snapshot;
+        take_snapshot(&snapshot, tiles, hash_tiles(tiles), random, board);
+
+        Tile restored_tiles[playfield_size][playfield_size];
+        uint64_t restored_hash;
+        Random restored_random;
+        int restored_points;
+        restore_snapshot(&snapshot, restored_tiles, &restored_hash, &restored_random, &restored_points);
+
+        if(
+            memcmp(tiles, restored_tiles, sizeof(tiles)) != 0 ||
+            restored_hash != hash_tiles(tiles) ||
+            restored_random.state != random.state ||
+            restored_points != board
+        ) {
+            return false;
+        }
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(packed_tile(&snapshot.tiles, x, y) != tiles[y][x]) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_snapshots() {
+    const auto round_count = 1 << 20;
+
+    Random random;
+    seed_random(&random, 15);
+
+    Tile tiles[playfield_size][playfield_size];
+    fill_random_tiles(tiles, &random);
+
+    auto hash = hash_tiles(tiles);
+    auto points = 0;
+
+    BoardSnapshot snapshot;
+
+    auto start_time = get_seconds();
+
+    for(auto i = 0; i < round_count; i += 1) {
+        take_snapshot(&snapshot, tiles, hash, random, points);
+
+        // Changes a tile so each round really has to take and restore a different board
+        tiles[i % playfield_size][0] = 1 + i % tile_kind_count;
+
+        restore_snapshot(&snapshot, tiles, &hash, &random, &points);
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("snapshot and restore", seconds, round_count, "rounds");
+
+    printf("    %.1f ns per snapshot and restore, %d bytes per snapshot (tile %d)\n", seconds * 1e9 / round_count, (int)sizeof(BoardSnapshot), tiles[3][0]);
+}
+
+// Observations must be one-hot, masks must be the swaps that score on the observed board, and
+// episodes must end after their length, starting over on a fresh board
+static bool check_environment() {
+    const auto board_count = 8;
+    const auto episode_length = 5;
+
+    auto observation_size = tile_kind_count * playfield_size * playfield_size;
+
+    auto environment = match_three_environment_create(board_count, episode_length, 2);
+
+    auto observations = (uint8_t*)malloc((size_t)board_count * observation_size);
+    auto action_masks = (uint8_t*)malloc((size_t)board_count * swap_count);
+    float rewards[board_count];
+    uint8_t dones[board_count];
+    int32_t actions[board_count];
+
+    auto valid = environment != nullptr;
+
+    match_three_environment_reset(environment, observations, action_masks);
+
+    for(auto step = 0; step <= episode_length && valid; step += 1) {
+        for(auto i = 0; i < board_count && valid; i += 1) {
+            auto observation = &observations[i * observation_size];
+            auto mask = &action_masks[i * swap_count];
+
+            Tile tiles[playfield_size][playfield_size] {};
+
+            for(auto kind = 1; kind <= tile_kind_count; kind += 1) {
+                for(auto y = 0; y < playfield_size; y += 1) {
+                    for(auto x = 0; x < playfield_size; x += 1) {
+                        if(observation[((kind - 1) * playfield_size + y) * playfield_size + x]) {
+                            valid = valid && tiles[y][x] == 0;
+
+                            tiles[y][x] = kind;
+                        }
+                    }
+                }
+            }
+
+            actions[i] = -1;
+
+            for(auto action = 0; action < swap_count; action += 1) {
+                auto scores = swap_scores(tiles, action);
+
+                valid = valid && mask[action] == scores;
+
+                if(scores && actions[i] == -1) {
+                    actions[i] = action;
+                }
+            }
+
+            for(auto y = 0; y < playfield_size; y += 1) {
+                for(auto x = 0; x < playfield_size; x += 1) {
+                    valid = valid && tiles[y][x] != 0;
+                }
+            }
+
+            valid = valid && actions[i] != -1;
+        }
+
+        if(!valid) {
+            break;
+        }
+
+        // Out of range actions step nothing
+        actions[0] += swap_count;
+        valid = valid && match_three_environment_step(environment, actions, observations, rewards, dones, action_masks) == -1;
+        actions[0] -= swap_count;
+
+        valid = valid && match_three_environment_step(environment, actions, observations, rewards, dones, action_masks) == 0;
+
+        for(auto i = 0; i < board_count && valid; i += 1) {
+            valid = rewards[i] >= 3 && ((step + 1) % episode_length != 0 || dones[i]);
+        }
+    }
+
+    free(observations);
+    free(action_masks);
+
+    match_three_environment_destroy(environment);
+
+    return valid;
+}
+
+static void benchmark_environment() {
+    const auto board_count = 1024;
+    const auto step_count = 200;
+
+    auto environment = match_three_environment_create(board_count, 100, 1);
+
+    auto observations = (uint8_t*)malloc((size_t)board_count * tile_kind_count * playfield_size * playfield_size);
+    auto action_masks = (uint8_t*)malloc((size_t)board_count * swap_count);
+    auto rewards = (float*)malloc(board_count * sizeof(float));
+    auto dones = (uint8_t*)malloc(board_count);
+    auto actions = (int32_t*)malloc(board_count * sizeof(int32_t));
+
+    match_three_environment_reset(environment, observations, action_masks);
+
+    Random random;
+    seed_random(&random, 1);
+
+    auto start_time = get_seconds();
+
+    for(auto step = 0; step < step_count; step += 1) {
+        // Picks the first available swap after a random starting point, as a masked policy would
+        for(auto i = 0; i < board_count; i += 1) {
+            auto mask = &action_masks[i * swap_count];
+
+            auto first = (int)(next_random(&random) % swap_count);
+
+            actions[i] = first;
+            for(auto offset = 0; offset < swap_count; offset += 1) {
+                auto action = (first + offset) % swap_count;
+
+                if(mask[action]) {
+                    actions[i] = action;
+
+                    break;
+                }
+            }
+        }
+
+        match_three_environment_step(environment, actions, observations, rewards, dones, action_masks);
+    }
+
+    report("environment steps", get_seconds() - start_time, (long long)board_count * step_count);
+
+    free(observations);
+    free(action_masks);
+    free(rewards);
+    free(dones);
+    free(actions);
+
+    match_three_environment_destroy(environment);
+}
+
+static bool check_incremental_hash() {
+    Random random;
+    seed_random(&random, 4);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        auto hash = hash_tiles(tiles);
+
+        // Every other board runs with refill off, leaving gaps to swap through
+        auto refill_random = board % 2 == 0 ? &random : nullptr;
+
+        for(auto move = 0; move < 50; move += 1) {
+            simulate_swap(tiles, refill_random, (int)(next_random(&random) % swap_count), &hash);
+
+            if(hash != hash_tiles(tiles)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool check_canonical_forms() {
+    Random random;
+    seed_random(&random, 6);
+
+    for(auto board = 0; board < 1000; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        // Mirrors the board and shifts every kind along by one
+        Tile equivalent_tiles[playfield_size][playfield_size];
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                equivalent_tiles[y][playfield_size - 1 - x] = tiles[y][x] % tile_kind_count + 1;
+            }
+        }
+
+        CanonicalBoard canonical;
+        CanonicalBoard equivalent_canonical;
+        canonicalize(tiles, &canonical);
+        canonicalize(equivalent_tiles, &equivalent_canonical);
+
+        if(canonical.hash != equivalent_canonical.hash || memcmp(canonical.tiles, equivalent_canonical.tiles, sizeof(tiles)) != 0) {
+            return false;
+        }
+
+        for(auto i = 0; i < swap_count; i += 1) {
+            if(swap_points(tiles, i) != swap_points(canonical.tiles, canonical_swap_index(&canonical, i))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_canonicalize() {
+    const auto board_count = 1 << 16;
+
+    Random random;
+    seed_random(&random, 7);
+
+    auto boards = (Tile(*)[playfield_size][playfield_size])malloc(board_count * sizeof(Tile[playfield_size][playfield_size]));
+    for(auto i = 0; i < board_count; i += 1) {
+        fill_random_tiles(boards[i], &random);
+    }
+
+    uint64_t combined_hash = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto i = 0; i < board_count; i += 1) {
+        CanonicalBoard canonical;
+        canonicalize(boards[i], &canonical);
+
+        combined_hash ^= canonical.hash;
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    report("canonicalize", seconds, board_count, "boards");
+    printf("    %.0f ns per board (%016llx)\n", seconds * 1e9 / board_count, (unsigned long long)combined_hash);
+
+    free(boards);
+}
+
+// With refill off, equivalent boards can share table entries through their canonical hash
+static int search_best_points(Tile tiles[playfield_size][playfield_size], uint64_t hash, int depth, TranspositionTable *table, bool canonical_keys, TranspositionStats *stats, long long *nodes) {
+    *nodes += 1;
+
+    if(depth == 0) {
+        return 0;
+    }
+
+    auto key = hash;
+    if(canonical_keys) {
+        CanonicalBoard canonical;
+        canonicalize(tiles, &canonical);
+
+        key = canonical.hash;
+    }
+
+    TranspositionEntry entry;
+    if(table != nullptr && transposition_probe(table, key, &entry, stats) && entry.depth >= depth) {
+        return entry.value;
+    }
+
+    int scoring_swaps[swap_count];
+    auto scoring_count = find_scoring_swaps(tiles, scoring_swaps);
+
+    auto best_points = 0;
+
+    for(auto i = 0; i < scoring_count; i += 1) {
+        Tile child_tiles[playfield_size][playfield_size];
+        memcpy(child_tiles, tiles, sizeof(child_tiles));
+
+        auto child_hash = hash;
+
+        auto points = simulate_swap(child_tiles, nullptr, scoring_swaps[i], &child_hash);
+        points += search_best_points(child_tiles, child_hash, depth - 1, table, canonical_keys, stats, nodes);
+
+        if(points > best_points) {
+            best_points = points;
+        }
+    }
+
+    if(table != nullptr) {
+        transposition_store(table, key, { best_points, -1, depth, Bound::Exact }, stats);
+    }
+
+    return best_points;
+}
+
+static void benchmark_transpositions() {
+    const auto depth = 3;
+
+    Random random;
+    seed_random(&random, 5);
+
+    Tile tiles[playfield_size][playfield_size];
+    fill_random_tiles(tiles, &random);
+
+    auto hash = hash_tiles(tiles);
+
+    long long plain_nodes = 0;
+
+    auto start_time = get_seconds();
+    auto plain_points = search_best_points(tiles, hash, depth, nullptr, false, nullptr, &plain_nodes);
+    report("search without table", get_seconds() - start_time, plain_nodes, "nodes");
+
+    printf("    best points %d, nodes %lld\n", plain_points, plain_nodes);
+
+    TranspositionTable table;
+    transposition_init(&table, 64 << 20);
+
+    for(auto canonical_keys = 0; canonical_keys < 2; canonical_keys += 1) {
+        transposition_clear(&table);
+
+        TranspositionStats stats {};
+        long long table_nodes = 0;
+
+        start_time = get_seconds();
+        auto table_points = search_best_points(tiles, hash, depth, &table, canonical_keys, &stats, &table_nodes);
+        report(canonical_keys ? "search with canonical table" : "search with table", get_seconds() - start_time, table_nodes, "nodes");
+
+        printf("    best points %d, nodes %lld\n", table_points, table_nodes);
+        printf("    %llu probes, %.1f%% hits, %llu stores, %llu replacements\n",
+            (unsigned long long)stats.probes,
+            100.0 * stats.hits / stats.probes,
+            (unsigned long long)stats.stores,
+            (unsigned long long)stats.replacements
+        );
+    }
+
+    transposition_free(&table);
+}
+
+// Fills a size by size board in the bottom left corner of the playfield and leaves the rest empty
+static void fill_small_board(Tile tiles[playfield_size][playfield_size], Random *random, int size) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            tiles[y][x] = 0;
+
+            if(x < size && y >= playfield_size - size) {
+                tiles[y][x] = random_tile_kind(random);
+            }
+        }
+    }
+}
+
+static bool check_solver_matches_search() {
+    Random random;
+    seed_random(&random, 6);
+
+    TranspositionTable table;
+    transposition_init(&table, 16 << 20);
+
+    auto matches = true;
+
+    for(auto board = 0; board < 20 && matches; board += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        fill_small_board(tiles, &random, 6);
+
+        long long nodes = 0;
+        auto points = search_best_points(tiles, hash_tiles(tiles), 4, nullptr, false, nullptr, &nodes);
+
+        // Workers share the table and cut-off bound, so any number of them must agree
+        SolverResult result;
+
+        for(auto thread_count = 1; thread_count <= 4; thread_count *= 2) {
+            transposition_clear(&table);
+
+            solve_best_points(tiles, nullptr, 4, thread_count, &table, &result);
+
+            if(result.points != points) {
+                matches = false;
+            }
+        }
+
+        // The first swap has to lead to a line that actually scores the best points
+        if(result.swap_index != -1) {
+            auto swap_points = simulate_swap(tiles, nullptr, result.swap_index);
+
+            if(swap_points + search_best_points(tiles, hash_tiles(tiles), 3, nullptr, false, nullptr, &nodes) != points) {
+                matches = false;
+            }
+        }
+    }
+
+    transposition_free(&table);
+
+    return matches;
+}
+
+static void benchmark_solver() {
+    const auto board_size = 6;
+    const auto depth = 6;
+
+    Random random;
+    seed_random(&random, 7);
+
+    Tile tiles[playfield_size][playfield_size];
+    fill_small_board(tiles, &random, board_size);
+
+    TranspositionTable table;
+    transposition_init(&table, 64 << 20);
+
+    int thread_counts[] = { 1, (int)std::thread::hardware_concurrency() };
+
+    for(auto thread_count : thread_counts) {
+        transposition_clear(&table);
+
+        SolverResult result;
+
+        auto start_time = get_seconds();
+        solve_best_points(tiles, nullptr, depth, thread_count, &table, &result);
+
+        char name[64];
+        snprintf(name, sizeof(name), "solve %dx%d depth %d, %d threads", board_size, board_size, depth, thread_count);
+        report(name, get_seconds() - start_time, result.nodes, "nodes");
+
+        printf("    best points %d, first swap %d, nodes %lld, %.1f%% hits\n", result.points, result.swap_index, result.nodes, 100.0 * result.stats.hits / result.stats.probes);
+    }
+
+    transposition_free(&table);
+}
+
+const auto strength_game_count = 8;
+const auto strength_game_length = 30;
+
+static void benchmark_strength(const char *name, PlayoutPolicy policy, double time_limit) {
+    MctsPlayer player;
+    mcts_init(&player, policy, (int)std::thread::hardware_concurrency(), 1);
+
+    long long total_points = 0;
+
+    auto start_time = get_seconds();
+
+    for(auto game = 0; game < strength_game_count; game += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)game + 1000);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        mcts_set_root(&player, tiles);
+
+        for(auto move = 0; move < strength_game_length; move += 1) {
+            auto swap_index = mcts_search(&player, time_limit);
+
+            if(swap_index == -1) {
+                break;
+            }
+
+            total_points += simulate_swap(tiles, &random, swap_index);
+
+            mcts_advance(&player, swap_index, tiles);
+        }
+    }
+
+    report(name, get_seconds() - start_time, (long long)strength_game_count * strength_game_length);
+
+    printf("    average points %.1f over %d moves\n", (double)total_points / strength_game_count, strength_game_length);
+
+    mcts_free(&player);
+}
+
+static void benchmark_greedy_strength() {
+    long long total_points = 0;
+
+    for(auto game = 0; game < strength_game_count; game += 1) {
+        Random random;
+        seed_random(&random, (uint32_t)game + 1000);
+
+        Tile tiles[playfield_size][playfield_size];
+        fill_random_tiles(tiles, &random);
+
+        for(auto move = 0; move < strength_game_length; move += 1) {
+            auto best_swap = -1;
+            auto best_points = 0;
+
+            for(auto i = 0; i < swap_count; i += 1) {
+                auto points = swap_points(tiles, i);
+
+                if(points > best_points) {
+                    best_swap = i;
+                    best_points = points;
+                }
+            }
+
+            if(best_swap == -1) {
+                break;
+            }
+
+            total_points += simulate_swap(tiles, &random, best_swap);
+        }
+    }
+
+    printf("greedy player\n    average points %.1f over %d moves\n", (double)total_points / strength_game_count, strength_game_length);
+}
+
+int main(int argument_count, const char *arguments[]) {
+    if(!check_lockstep_matches_scalar()) {
+        printf("lockstep engine does not match scalar rules\n");
+
+        return 1;
+    }
+
+    if(!check_move_generator_matches_scalar()) {
+        printf("move generator does not match scalar rules\n");
+
+        return 1;
+    }
+
+    if(!check_incremental_hash()) {
+        printf("incremental hash does not match full hash\n");
+
+        return 1;
+    }
+
+    if(!check_canonical_forms()) {
+        printf("equivalent boards have different canonical forms\n");
+
+        return 1;
+    }
+
+    if(!check_bordered_matches_scalar()) {
+        printf("bordered layout does not match scalar rules\n");
+
+        return 1;
+    }
+
+    if(!check_columns_match_scalar()) {
+        printf("column-major layout does not match scalar rules\n");
+
+        return 1;
+    }
+
+    if(!check_runs_match_scalar()) {
+        printf("run detector does not match scalar runs\n");
+
+        return 1;
+    }
+
+    if(!check_animation_rates()) {
+        printf("animations depend on the frame rate\n");
+
+        return 1;
+    }
+
+    if(!check_visual_handles()) {
+        printf("visual entity handles or components are inconsistent\n");
+
+        return 1;
+    }
+
+    if(!check_refill_policies()) {
+        printf("refill policies do not repeat or draw out of order\n");
+
+        return 1;
+    }
+
+    if(!check_environment()) {
+        printf("environment observations, masks or episodes are wrong\n");
+
+        return 1;
+    }
+
+    if(!check_spsc_order()) {
+        printf("input queue loses or reorders values\n");
+
+        return 1;
+    }
+
+    if(!check_triple_buffer()) {
+        printf("triple buffer hands out stale or written slots\n");
+
+        return 1;
+    }
+
+    if(!check_tween_precision()) {
+        printf("tweens lose precision as the game runs\n");
+
+        return 1;
+    }
+
+    if(!check_snapshots()) {
+        printf("restored snapshots do not match their boards\n");
+
+        return 1;
+    }
+
+    if(!check_generated_boards()) {
+        printf("generated boards have groups or too few moves\n");
+
+        return 1;
+    }
+
+    if(!check_potential_groups()) {
+        printf("potential groups do not match swapped boards\n");
+
+        return 1;
+    }
+
+    if(!check_solver_matches_search()) {
+        printf("solver does not match exhaustive search\n");
+
+        return 1;
+    }
+
+    benchmark_scalar_rollouts();
+    benchmark_bordered_rollouts();
+    benchmark_column_rollouts();
+    benchmark_lockstep_rollouts();
+    benchmark_rule_rollouts("group rule rollouts", MatchRule::Groups);
+    benchmark_rule_rollouts("line rule rollouts", MatchRule::Lines);
+    benchmark_run_detection();
+    benchmark_gravity();
+    benchmark_move_generators();
+    benchmark_refill_policies();
+    benchmark_environment();
+    benchmark_potential_groups();
+    benchmark_generator();
+    benchmark_snapshots();
+    benchmark_tweens();
+    benchmark_visuals();
+    benchmark_canonicalize();
+    benchmark_transpositions();
+    benchmark_solver();
+
+    benchmark_greedy_strength();
+    benchmark_strength("mcts random playouts 5 ms", PlayoutPolicy::Random, 0.005);
+    benchmark_strength("mcts greedy playouts 5 ms", PlayoutPolicy::Greedy, 0.005);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include "bordered.h"
+#include <string.h>
+
+void bordered_load(BorderedTiles *bordered, const Tile tiles[playfield_size][playfield_size]) {
+    memset(bordered->cells, sentinel_tile, sizeof(bordered->cells));
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        memcpy(&bordered->cells[bordered_index(0, y)], tiles[y], playfield_size * sizeof(Tile));
+    }
+}
+
+void bordered_store(const BorderedTiles *bordered, Tile tiles[playfield_size][playfield_size]) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        memcpy(tiles[y], &bordered->cells[bordered_index(0, y)], playfield_size * sizeof(Tile));
+    }
+}
+
+static inline int same_kind_neighbours(const Tile cells[], int index, Tile kind) {
+    return
+        (int)(cells[index + 1] == kind) +
+        (int)(cells[index + bordered_width] == kind) +
+        (int)(cells[index - 1] == kind) +
+        (int)(cells[index - bordered_width] == kind);
+}
+
+bool bordered_in_group(const BorderedTiles *bordered, int index) {
+    auto cells = bordered->cells;
+    auto kind = cells[index];
+
+    if(kind == 0) {
+        return false;
+    }
+
+    auto right = (int)(cells[index + 1] == kind);
+    auto below = (int)(cells[index + bordered_width] == kind);
+    auto left = (int)(cells[index - 1] == kind);
+    auto above = (int)(cells[index - bordered_width] == kind);
+
+    auto count = right + below + left + above;
+
+    if(count != 1) {
+        return count >= 2;
+    }
+
+    auto neighbour = index + right - left + (below - above) * bordered_width;
+
+    return same_kind_neighbours(cells, neighbour, kind) >= 2;
+}
+
+static inline void swap_cells_from_index(int swap_index, int *from, int *to) {
+    if(swap_index < horizontal_swap_count) {
+        *from = bordered_index(swap_index % (playfield_size - 1), swap_index / (playfield_size - 1));
+        *to = *from + 1;
+    } else {
+        auto vertical_index = swap_index - horizontal_swap_count;
+
+        *from = bordered_index(vertical_index % playfield_size, vertical_index / playfield_size);
+        *to = *from + bordered_width;
+    }
+}
+
+bool bordered_swap_scores(BorderedTiles *bordered, int swap_index) {
+    int from;
+    int to;
+    swap_cells_from_index(swap_index, &from, &to);
+
+    auto cells = bordered->cells;
+
+    auto from_tile_type = cells[from];
+    auto to_tile_type = cells[to];
+
+    if(from_tile_type == 0 || to_tile_type == 0) {
+        return false;
+    }
+
+    cells[from] = to_tile_type;
+    cells[to] = from_tile_type;
+
+    auto scores = bordered_in_group(bordered, to) | bordered_in_group(bordered, from);
+
+    cells[from] = from_tile_type;
+    cells[to] = to_tile_type;
+
+    return scores;
+}
+
+int bordered_find_scoring_swaps(BorderedTiles *bordered, int swap_indices[swap_count]) {
+    auto count = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        if(bordered_swap_scores(bordered, i)) {
+            swap_indices[count] = i;
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+int bordered_collect_group(const Tile cells[], bool visited[], int start, Tile kind, int group[], int group_count) {
+    auto first = group_count;
+
+    visited[start] = true;
+    group[group_count] = start;
+    group_count += 1;
+
+    for(auto i = first; i < group_count; i += 1) {
+        for(auto j = 0; j < 4; j += 1) {
+            auto neighbour = group[i] + bordered_neighbour_offsets[j];
+
+            if(cells[neighbour] == kind && !visited[neighbour]) {
+                visited[neighbour] = true;
+                group[group_count] = neighbour;
+                group_count += 1;
+            }
+        }
+    }
+
+    return group_count;
+}
+
+static void settle_bordered(Tile cells[], Random *random) {
+    for(auto x = 0; x < playfield_size; x += 1) {
+        auto top = bordered_index(x, 0);
+        auto write = bordered_index(x, playfield_size - 1);
+
+        for(auto read = write; read >= top; read -= bordered_width) {
+            auto kind = cells[read];
+
+            if(kind != 0) {
+                cells[write] = kind;
+                write -= bordered_width;
+            }
+        }
+
+        // Same order as settle_tiles, so both draw the same kinds: column by column, top down
+        for(auto index = top; index <= write; index += bordered_width) {
+            cells[index] = random != nullptr ? (Tile)random_tile_kind(random) : 0;
+        }
+    }
+}
+
+int bordered_simulate_swap(BorderedTiles *bordered, Random *random, int swap_index) {
+    int from;
+    int to;
+    swap_cells_from_index(swap_index, &from, &to);
+
+    auto cells = bordered->cells;
+
+    auto from_tile_type = cells[from];
+    auto to_tile_type = cells[to];
+
+    cells[from] = to_tile_type;
+    cells[to] = from_tile_type;
+
+    bool visited[bordered_cell_count] {};
+    int group[playfield_size * playfield_size];
+
+    auto points = 0;
+
+    if(from_tile_type != 0 && !visited[to]) {
+        auto count = bordered_collect_group(cells, visited, to, from_tile_type, group, 0);
+
+        if(count >= 3) {
+            points += count;
+
+            for(auto i = 0; i < count; i += 1) {
+                cells[group[i]] = 0;
+            }
+        }
+    }
+
+    if(to_tile_type != 0 && !visited[from]) {
+        auto count = bordered_collect_group(cells, visited, from, to_tile_type, group, 0);
+
+        if(count >= 3) {
+            points += count;
+
+            for(auto i = 0; i < count; i += 1) {
+                cells[group[i]] = 0;
+            }
+        }
+    }
+
+    if(points != 0) {
+        settle_bordered(cells, random);
+    }
+
+    return points;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// The same board with a ring of sentinel tiles around it, stored as one flat array. Sentinels
+// never match a kind or read as empty, so flood fills, group tests and gravity step between
+// neighbours by adding a fixed offset and never check whether they left the playfield.
+const auto bordered_width = playfield_size + 2;
+const auto bordered_cell_count = bordered_width * bordered_width;
+
+const Tile sentinel_tile = 0xFF;
+
+struct BorderedTiles {
+    Tile cells[bordered_cell_count];
+};
+
+const int bordered_neighbour_offsets[4] { 1, bordered_width, -1, -bordered_width };
+
+static inline int bordered_index(int x, int y) {
+    return (y + 1) * bordered_width + x + 1;
+}
+
+void bordered_load(BorderedTiles *bordered, const Tile tiles[playfield_size][playfield_size]);
+
+void bordered_store(const BorderedTiles *bordered, Tile tiles[playfield_size][playfield_size]);
+
+bool bordered_in_group(const BorderedTiles *bordered, int index);
+
+// Adds the unvisited group of kind around start to group, from group_count on, and returns the
+// new count. Stepping onto sentinels ends the fill at the edges without any bounds checks.
+int bordered_collect_group(const Tile cells[], bool visited[], int start, Tile kind, int group[], int group_count);
+
+bool bordered_swap_scores(BorderedTiles *bordered, int swap_index);
+
+int bordered_find_scoring_swaps(BorderedTiles *bordered, int swap_indices[swap_count]);
+
+// Scores, clears, settles and refills exactly as simulate_swap does
+int bordered_simulate_swap(BorderedTiles *bordered, Random *random, int swap_index);
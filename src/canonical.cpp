@@ -0,0 +1,85 @@
+#include "canonical.h"
+#include <string.h>
+#include "zobrist.h"
+
+static int oriented_tile(const Tile tiles[playfield_size][playfield_size], bool mirror, int x, int y) {
+    return mirror ? tiles[y][playfield_size - 1 - x] : tiles[y][x];
+}
+
+// Numbers kinds in order of first appearance, which usually settles within the first rows
+static void number_kinds(const Tile tiles[playfield_size][playfield_size], bool mirror, int kinds[tile_kind_count + 1]) {
+    memset(kinds, 0, (tile_kind_count + 1) * sizeof(int));
+
+    auto next_kind = 1;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto kind = oriented_tile(tiles, mirror, x, y);
+
+            if(kind != 0 && kinds[kind] == 0) {
+                kinds[kind] = next_kind;
+                next_kind += 1;
+
+                if(next_kind > tile_kind_count) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// Whether the relabelled mirror comes before the relabelled board, tile by tile
+static bool mirror_comes_first(const Tile tiles[playfield_size][playfield_size], const int kinds[tile_kind_count + 1], const int mirrored_kinds[tile_kind_count + 1]) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto kind = kinds[tiles[y][x]];
+            auto mirrored_kind = mirrored_kinds[tiles[y][playfield_size - 1 - x]];
+
+            if(kind != mirrored_kind) {
+                return mirrored_kind < kind;
+            }
+        }
+    }
+
+    return false;
+}
+
+void canonicalize(const Tile tiles[playfield_size][playfield_size], CanonicalBoard *canonical) {
+    int mirrored_kinds[tile_kind_count + 1];
+
+    number_kinds(tiles, false, canonical->kinds);
+    number_kinds(tiles, true, mirrored_kinds);
+
+    canonical->mirrored = mirror_comes_first(tiles, canonical->kinds, mirrored_kinds);
+
+    if(canonical->mirrored) {
+        memcpy(canonical->kinds, mirrored_kinds, sizeof(mirrored_kinds));
+    }
+
+    uint64_t hash = 0;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto kind = canonical->kinds[oriented_tile(tiles, canonical->mirrored, x, y)];
+
+            canonical->tiles[y][x] = kind;
+            hash ^= zobrist_key(x, y, kind);
+        }
+    }
+
+    canonical->hash = hash;
+}
+
+int mirror_swap_index(int swap_index) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    if(swap_index < horizontal_swap_count) {
+        return from_y * (playfield_size - 1) + (playfield_size - 2 - from_x);
+    } else {
+        return horizontal_swap_count + from_y * playfield_size + (playfield_size - 1 - from_x);
+    }
+}
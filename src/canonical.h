@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// Boards that only differ by a left-right mirror or by which kind is which play out the same
+// under gravity when refill is off, so they share one canonical form: of the board and its
+// mirror, each with kinds renumbered in order of first appearance, the lexicographically
+// smaller one. With refill on the upcoming kinds are fixed, and this no longer holds.
+struct CanonicalBoard {
+    Tile tiles[playfield_size][playfield_size];
+
+    uint64_t hash;
+
+    bool mirrored;
+
+    // Canonical kind for each original kind, with 0 for kinds not on the board
+    int kinds[tile_kind_count + 1];
+};
+
+void canonicalize(const Tile tiles[playfield_size][playfield_size], CanonicalBoard *canonical);
+
+int mirror_swap_index(int swap_index);
+
+// Maps a swap on the original board to the same swap on its canonical board. Mirroring is its
+// own inverse, so this also maps canonical swaps back.
+static inline int canonical_swap_index(const CanonicalBoard *canonical, int swap_index) {
+    return canonical->mirrored ? mirror_swap_index(swap_index) : swap_index;
+}
@@ -0,0 +1,223 @@
+#include "columns.h"
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define COLUMN_SHUFFLE
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SSSE3_FUNCTION
+#else
+#define SSSE3_FUNCTION __attribute__((target("ssse3")))
+#endif
+#endif
+
+void column_load(ColumnTiles *columns, const Tile tiles[playfield_size][playfield_size]) {
+    memset(columns->cells, column_sentinel_tile, sizeof(columns->cells));
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        for(auto y = 0; y < playfield_size; y += 1) {
+            columns->cells[column_index(x, y)] = tiles[y][x];
+        }
+    }
+}
+
+void column_store(const ColumnTiles *columns, Tile tiles[playfield_size][playfield_size]) {
+    for(auto x = 0; x < playfield_size; x += 1) {
+        for(auto y = 0; y < playfield_size; y += 1) {
+            tiles[y][x] = columns->cells[column_index(x, y)];
+        }
+    }
+}
+
+static int compact_column(Tile column[]) {
+    auto count = 0;
+
+    for(auto i = 0; i < playfield_size; i += 1) {
+        auto kind = column[i];
+
+        if(kind != 0) {
+            column[count] = kind;
+            count += 1;
+        }
+    }
+
+    for(auto i = count; i < playfield_size; i += 1) {
+        column[i] = 0;
+    }
+
+    return count;
+}
+
+#if defined(COLUMN_SHUFFLE)
+// Shuffle controls that pack the set bits of a byte mask to the front, one table for each half
+// of a column, with 0x80 to zero the rest
+struct PackControls {
+    uint8_t low[256][8];
+    uint8_t high[256][8];
+    uint8_t counts[256];
+};
+
+static PackControls pack_controls;
+
+static bool cpu_has_ssse3() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+
+    return (info[2] & (1 << 9)) != 0;
+#else
+    // Runs before main, possibly before the runtime has looked at the processor itself
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static bool initialize_pack_controls() {
+    for(auto mask = 0; mask < 256; mask += 1) {
+        auto count = 0;
+
+        for(auto bit = 0; bit < 8; bit += 1) {
+            pack_controls.low[mask][bit] = 0x80;
+            pack_controls.high[mask][bit] = 0x80;
+        }
+
+        for(auto bit = 0; bit < 8; bit += 1) {
+            if((mask >> bit) & 1) {
+                pack_controls.low[mask][count] = (uint8_t)bit;
+                pack_controls.high[mask][count] = (uint8_t)(bit + 8);
+                count += 1;
+            }
+        }
+
+        pack_controls.counts[mask] = (uint8_t)count;
+    }
+
+    return cpu_has_ssse3();
+}
+
+static bool use_shuffle = initialize_pack_controls();
+
+SSSE3_FUNCTION static int shuffle_column(Tile column[]) {
+    const auto tile_lanes = (1 << playfield_size) - 1;
+
+    auto values = _mm_load_si128((const __m128i*)column);
+
+    auto keep = ~_mm_movemask_epi8(_mm_cmpeq_epi8(values, _mm_setzero_si128())) & tile_lanes;
+
+    auto low = keep & 0xFF;
+    auto high = (keep >> 8) & 0xFF;
+
+    auto low_count = pack_controls.counts[low];
+
+    // The high half's control goes right after the low half's tiles
+    alignas(16) uint8_t control[column_stride];
+    memcpy(control, pack_controls.low[low], 8);
+    memset(control + 8, 0x80, 8);
+    memcpy(control + low_count, pack_controls.high[high], 8);
+
+    auto packed = _mm_shuffle_epi8(values, _mm_load_si128((const __m128i*)control));
+
+    // Lanes above the top tile come out zero and get their sentinels back
+    auto sentinels = _mm_andnot_si128(
+        _mm_cmpgt_epi8(_mm_set1_epi8(playfield_size), _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)),
+        _mm_set1_epi8((char)column_sentinel_tile)
+    );
+
+    _mm_store_si128((__m128i*)column, _mm_or_si128(packed, sentinels));
+
+    return low_count + pack_controls.counts[high];
+}
+#endif
+
+void column_settle(ColumnTiles *columns, Random *random) {
+    for(auto x = 0; x < playfield_size; x += 1) {
+        auto column = &columns->cells[(x + 1) * column_stride];
+
+#if defined(COLUMN_SHUFFLE)
+        auto count = use_shuffle ? shuffle_column(column) : compact_column(column);
+#else
+        auto count = compact_column(column);
+#endif
+
+        // Top down, as settle_tiles refills, so both draw the same kinds
+        for(auto i = playfield_size - 1; i >= count; i -= 1) {
+            column[i] = random != nullptr ? (Tile)random_tile_kind(random) : 0;
+        }
+    }
+}
+
+static int collect_group(const Tile cells[], bool visited[], int start, Tile kind, int group[]) {
+    auto group_count = 1;
+
+    visited[start] = true;
+    group[0] = start;
+
+    for(auto i = 0; i < group_count; i += 1) {
+        for(auto j = 0; j < 4; j += 1) {
+            auto neighbour = group[i] + column_neighbour_offsets[j];
+
+            if(cells[neighbour] == kind && !visited[neighbour]) {
+                visited[neighbour] = true;
+                group[group_count] = neighbour;
+                group_count += 1;
+            }
+        }
+    }
+
+    return group_count;
+}
+
+int column_simulate_swap(ColumnTiles *columns, Random *random, int swap_index) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from = column_index(from_x, from_y);
+    auto to = column_index(to_x, to_y);
+
+    auto cells = columns->cells;
+
+    auto from_tile_type = cells[from];
+    auto to_tile_type = cells[to];
+
+    cells[from] = to_tile_type;
+    cells[to] = from_tile_type;
+
+    bool visited[column_cell_count] {};
+    int group[playfield_size * playfield_size];
+
+    auto points = 0;
+
+    if(from_tile_type != 0) {
+        auto count = collect_group(cells, visited, to, from_tile_type, group);
+
+        if(count >= 3) {
+            points += count;
+
+            for(auto i = 0; i < count; i += 1) {
+                cells[group[i]] = 0;
+            }
+        }
+    }
+
+    if(to_tile_type != 0 && !visited[from]) {
+        auto count = collect_group(cells, visited, from, to_tile_type, group);
+
+        if(count >= 3) {
+            points += count;
+
+            for(auto i = 0; i < count; i += 1) {
+                cells[group[i]] = 0;
+            }
+        }
+    }
+
+    if(points != 0) {
+        column_settle(columns, random);
+    }
+
+    return points;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// The board stored column by column, each column a contiguous 16 bytes running from the bottom
+// tile up, so gravity reads and writes whole columns at once. Bytes past the top tile and two
+// extra columns at either side hold sentinel tiles, which play the same part as the border of
+// BorderedTiles: stepping off the board in any direction lands on a tile that matches nothing.
+//
+// This layout is an alternative the benchmark measures against the row-major board, not what
+// the game or the solvers run on. Loading and storing it around each settle_tiles costs more
+// than the shuffle saves, so it only pays where a whole rollout stays column-major.
+const auto column_stride = 16;
+const auto column_cell_count = (playfield_size + 2) * column_stride;
+
+static_assert(playfield_size < column_stride, "Columns must leave room for a sentinel above the top tile");
+
+const Tile column_sentinel_tile = 0xFF;
+
+struct alignas(16) ColumnTiles {
+    Tile cells[column_cell_count];
+};
+
+const int column_neighbour_offsets[4] { column_stride, 1, -column_stride, -1 };
+
+static inline int column_index(int x, int y) {
+    return (x + 1) * column_stride + playfield_size - 1 - y;
+}
+
+void column_load(ColumnTiles *columns, const Tile tiles[playfield_size][playfield_size]);
+
+void column_store(const ColumnTiles *columns, Tile tiles[playfield_size][playfield_size]);
+
+// Gravity and refill, exactly as settle_tiles: each column is compacted with a single byte
+// shuffle where the processor has one
+void column_settle(ColumnTiles *columns, Random *random);
+
+int column_simulate_swap(ColumnTiles *columns, Random *random, int swap_index);
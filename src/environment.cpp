@@ -0,0 +1,156 @@
+#include "environment.h"
+#include <stdlib.h>
+#include <string.h>
+#include "rules.h"
+
+struct EnvironmentBoard {
+    Tile tiles[playfield_size][playfield_size];
+
+    Random random;
+
+    int moves;
+};
+
+struct MatchThreeEnvironment {
+    int board_count;
+    int episode_length;
+
+    EnvironmentBoard *boards;
+};
+
+const auto observation_size = tile_kind_count * playfield_size * playfield_size;
+
+int match_three_board_size(void) {
+    return playfield_size;
+}
+
+int match_three_kind_count(void) {
+    return tile_kind_count;
+}
+
+int match_three_action_count(void) {
+    return swap_count;
+}
+
+static void reset_board(EnvironmentBoard *board) {
+    fill_random_tiles(board->tiles, &board->random);
+
+    board->moves = 0;
+}
+
+MatchThreeEnvironment *match_three_environment_create(int board_count, int episode_length, uint32_t seed) {
+    if(board_count <= 0 || episode_length <= 0) {
+        return nullptr;
+    }
+
+    auto environment = (MatchThreeEnvironment*)malloc(sizeof(MatchThreeEnvironment));
+    auto boards = (EnvironmentBoard*)malloc(board_count * sizeof(EnvironmentBoard));
+
+    if(environment == nullptr || boards == nullptr) {
+        free(environment);
+        free(boards);
+
+        return nullptr;
+    }
+
+    environment->board_count = board_count;
+    environment->episode_length = episode_length;
+    environment->boards = boards;
+
+    Random seeds;
+    seed_random(&seeds, seed);
+
+    for(auto i = 0; i < board_count; i += 1) {
+        seed_random(&boards[i].random, next_random(&seeds));
+
+        // Every board starts out valid, so stepping before the first reset is safe
+        reset_board(&boards[i]);
+    }
+
+    return environment;
+}
+
+void match_three_environment_destroy(MatchThreeEnvironment *environment) {
+    if(environment == nullptr) {
+        return;
+    }
+
+    free(environment->boards);
+    free(environment);
+}
+
+static void write_observation(const EnvironmentBoard *board, uint8_t *observation) {
+    memset(observation, 0, observation_size);
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto kind = board->tiles[y][x];
+
+            observation[((kind - 1) * playfield_size + y) * playfield_size + x] = 1;
+        }
+    }
+}
+
+// Writes the action mask and returns how many swaps are available
+static int write_action_mask(EnvironmentBoard *board, uint8_t *action_mask) {
+    auto count = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        auto scores = swap_scores(board->tiles, i);
+
+        action_mask[i] = scores;
+        count += scores;
+    }
+
+    return count;
+}
+
+void match_three_environment_reset(MatchThreeEnvironment *environment, uint8_t *observations, uint8_t *action_masks) {
+    for(auto i = 0; i < environment->board_count; i += 1) {
+        auto board = &environment->boards[i];
+
+        reset_board(board);
+
+        write_observation(board, &observations[i * observation_size]);
+        write_action_mask(board, &action_masks[i * swap_count]);
+    }
+}
+
+int match_three_environment_step(
+    MatchThreeEnvironment *environment,
+    const int32_t *actions,
+    uint8_t *observations,
+    float *rewards,
+    uint8_t *dones,
+    uint8_t *action_masks
+) {
+    for(auto i = 0; i < environment->board_count; i += 1) {
+        if(actions[i] < 0 || actions[i] >= swap_count) {
+            return -1;
+        }
+    }
+
+    for(auto i = 0; i < environment->board_count; i += 1) {
+        auto board = &environment->boards[i];
+
+        rewards[i] = (float)simulate_swap(board->tiles, &board->random, actions[i]);
+
+        board->moves += 1;
+
+        auto action_mask = &action_masks[i * swap_count];
+
+        auto done = board->moves >= environment->episode_length || write_action_mask(board, action_mask) == 0;
+
+        if(done) {
+            reset_board(board);
+
+            write_action_mask(board, action_mask);
+        }
+
+        dones[i] = done;
+
+        write_observation(board, &observations[i * observation_size]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(MATCH_THREE_ENVIRONMENT_EXPORTS)
+#define MATCH_THREE_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define MATCH_THREE_API __declspec(dllimport)
+#else
+#define MATCH_THREE_API
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+    Batched environment over many independent boards for reinforcement learning.
+
+    Buffers are owned by the caller and written in place, board after board:
+        observations  uint8_t[board_count][kind_count][board_size][board_size], one-hot tile kinds
+        action_masks  uint8_t[board_count][action_count], 1 for swaps that complete a group
+        rewards       float[board_count], points scored by the step
+        dones         uint8_t[board_count], 1 when the episode ended on this step
+
+    Actions are swap indices, every horizontal pair (row by row) first, then every vertical pair.
+    A board whose episode ends is reset immediately, so the observation and action mask written
+    for it already belong to the next episode. An episode ends after episode_length moves, or
+    when no swap can complete a group.
+
+    Call order: create, then reset to get the first observations and action masks, then step as
+    often as needed, then destroy. Boards are already dealt by create, so a step before the first
+    reset plays on them rather than on uninitialized memory, but its caller has never seen them.
+*/
+
+typedef struct MatchThreeEnvironment MatchThreeEnvironment;
+
+MATCH_THREE_API int match_three_board_size(void);
+MATCH_THREE_API int match_three_kind_count(void);
+MATCH_THREE_API int match_three_action_count(void);
+
+MATCH_THREE_API MatchThreeEnvironment *match_three_environment_create(int board_count, int episode_length, uint32_t seed);
+MATCH_THREE_API void match_three_environment_destroy(MatchThreeEnvironment *environment);
+
+MATCH_THREE_API void match_three_environment_reset(MatchThreeEnvironment *environment, uint8_t *observations, uint8_t *action_masks);
+
+// Returns 0 on success, or -1 if any action is out of range, in which case nothing is stepped
+MATCH_THREE_API int match_three_environment_step(
+    MatchThreeEnvironment *environment,
+    const int32_t *actions,
+    uint8_t *observations,
+    float *rewards,
+    uint8_t *dones,
+    uint8_t *action_masks
+);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// Games report what happens in them as a stream of events, which anything that needs to know,
+// such as drawing, sound, statistics or a replay, reads at its own pace. Nothing is done for
+// any of them at the point where things happen, so a game without readers pays nothing. Only
+// the game emits events: the rules, and the headless simulations built on them, emit none.
+
+enum struct GameEventKind : uint8_t {
+    SwapAccepted,
+    GroupCleared,
+    TileFell,
+    TileSpawned,
+    ScoreChanged
+};
+
+struct SwapEvent {
+    int8_t from_x;
+    int8_t from_y;
+    int8_t to_x;
+    int8_t to_y;
+
+    int16_t points;
+};
+
+static_assert(playfield_size * playfield_size <= 128, "Group cells must fit in two words");
+
+// Cells are bits of y * playfield_size + x
+struct GroupEvent {
+    Tile kind;
+    uint8_t size;
+
+    uint64_t cells[2];
+};
+
+// Spawned tiles start above the playfield, at negative rows
+struct TileEvent {
+    int8_t x;
+    int8_t from_y;
+    int8_t to_y;
+
+    Tile kind;
+};
+
+struct ScoreEvent {
+    int32_t change;
+    int32_t total;
+};
+
+struct GameEvent {
+    GameEventKind kind;
+
+    // In GetTime seconds, for the game
+    double time;
+
+    union {
+        SwapEvent swap;
+        GroupEvent group;
+        TileEvent tile;
+        ScoreEvent score;
+    };
+};
+
+const auto game_event_capacity = 1024;
+
+static_assert((game_event_capacity & (game_event_capacity - 1)) == 0, "Capacity must be a power of two");
+
+// The newest events, written over oldest first. Each reader keeps a cursor of its own, the
+// count of events it has read, so readers never hold each other up.
+struct GameEventRing {
+    GameEvent events[game_event_capacity];
+
+    uint64_t written;
+};
+
+static inline void emit_event(GameEventRing *ring, const GameEvent &event) {
+    ring->events[ring->written & (game_event_capacity - 1)] = event;
+    ring->written += 1;
+}
+
+// Returns false once the reader has caught up. A reader that fell more than the capacity behind
+// has lost the events written over, and carries on from the oldest still there.
+static inline bool next_event(const GameEventRing *ring, uint64_t *cursor, GameEvent *event) {
+    if(*cursor == ring->written) {
+        return false;
+    }
+
+    if(ring->written - *cursor > (uint64_t)game_event_capacity) {
+        *cursor = ring->written - game_event_capacity;
+    }
+
+    *event = ring->events[*cursor & (game_event_capacity - 1)];
+    *cursor += 1;
+
+    return true;
+}
@@ -0,0 +1,156 @@
+#include "generator.h"
+#include <string.h>
+
+static int random_below(Random *random, int count) {
+    return (int)(((next_random(random) >> 16) * (uint32_t)count) >> 16);
+}
+
+static bool tile_has_kind(const Tile tiles[playfield_size][playfield_size], int x, int y, int kind) {
+    return in_playfield(x, y) && tiles[y][x] == kind;
+}
+
+// Sizes of the groups a tile of each kind would join at the empty (x, y). Groups on the board
+// never reach 3, so each neighbour's group is itself plus at most one more tile, and no two
+// neighbours can share a group.
+static void joined_group_sizes(const Tile tiles[playfield_size][playfield_size], int x, int y, int sizes[tile_kind_count + 1]) {
+    const int offsets[4][2] { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+
+    for(auto kind = 0; kind <= tile_kind_count; kind += 1) {
+        sizes[kind] = 1;
+    }
+
+    for(auto i = 0; i < 4; i += 1) {
+        auto neighbour_x = x + offsets[i][0];
+        auto neighbour_y = y + offsets[i][1];
+
+        if(!in_playfield(neighbour_x, neighbour_y) || tiles[neighbour_y][neighbour_x] == 0) {
+            continue;
+        }
+
+        auto kind = tiles[neighbour_y][neighbour_x];
+
+        sizes[kind] += 1;
+
+        for(auto j = 0; j < 4; j += 1) {
+            sizes[kind] += (int)tile_has_kind(tiles, neighbour_x + offsets[j][0], neighbour_y + offsets[j][1], kind);
+        }
+    }
+}
+
+// Cells of a planted swap along a line of 4, as offsets from its start: the pair, the gap and
+// the lone tile that swaps into the gap
+const int planted_patterns[2][4] {
+    { 0, 1, 2, 3 },
+    { 2, 3, 1, 0 }
+};
+
+int generate_tiles(Tile tiles[playfield_size][playfield_size], Random *random, int move_count) {
+    memset(tiles, 0, sizeof(Tile) * playfield_size * playfield_size);
+
+    // Lines of 4 that tile each half of every row and column, visited in a random order
+    const auto slots_per_line = playfield_size / 5 + (playfield_size % 5 >= 4 ? 1 : 0);
+    const auto slot_count = playfield_size * slots_per_line * 2;
+
+    int slots[slot_count];
+    for(auto i = 0; i < slot_count; i += 1) {
+        slots[i] = i;
+    }
+
+    bool reserved[playfield_size][playfield_size] {};
+
+    auto planted = 0;
+
+    for(auto i = 0; i < slot_count && planted < move_count; i += 1) {
+        auto other = i + random_below(random, slot_count - i);
+
+        auto slot = slots[other];
+        slots[other] = slots[i];
+        slots[i] = slot;
+
+        auto vertical = slot >= slot_count / 2;
+        auto line = (slot % (slot_count / 2)) / slots_per_line;
+        auto start = (slot % slots_per_line) * 5 + random_below(random, 2);
+
+        if(start + 4 > playfield_size) {
+            start = playfield_size - 4;
+        }
+
+        int cells[4][2];
+        auto unreserved = true;
+
+        auto pattern = planted_patterns[random_below(random, 2)];
+
+        for(auto j = 0; j < 4; j += 1) {
+            auto along = start + pattern[j];
+
+            cells[j][0] = vertical ? line : along;
+            cells[j][1] = vertical ? along : line;
+
+            unreserved = unreserved && !reserved[cells[j][1]][cells[j][0]];
+        }
+
+        if(!unreserved) {
+            continue;
+        }
+
+        // A kind the neighbouring planted tiles leave room for, starting from a random one
+        auto first_kind = random_below(random, tile_kind_count);
+
+        int pair_sizes[2][tile_kind_count + 1];
+        int lone_sizes[tile_kind_count + 1];
+
+        joined_group_sizes(tiles, cells[0][0], cells[0][1], pair_sizes[0]);
+        joined_group_sizes(tiles, cells[1][0], cells[1][1], pair_sizes[1]);
+        joined_group_sizes(tiles, cells[3][0], cells[3][1], lone_sizes);
+
+        for(auto j = 0; j < tile_kind_count; j += 1) {
+            auto kind = 1 + (first_kind + j) % tile_kind_count;
+
+            auto pair_size = pair_sizes[0][kind] + pair_sizes[1][kind];
+            auto lone_size = lone_sizes[kind];
+
+            if(pair_size > 2 || lone_size > 1) {
+                continue;
+            }
+
+            tiles[cells[0][1]][cells[0][0]] = kind;
+            tiles[cells[1][1]][cells[1][0]] = kind;
+            tiles[cells[3][1]][cells[3][0]] = kind;
+
+            for(auto k = 0; k < 4; k += 1) {
+                reserved[cells[k][1]][cells[k][0]] = true;
+            }
+
+            planted += 1;
+
+            break;
+        }
+    }
+
+    // Every empty tile has at most 4 neighbouring kinds to avoid, so with 6 kinds there is always
+    // one left, and gaps never get the kind that would complete their swap early
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            if(tiles[y][x] != 0) {
+                continue;
+            }
+
+            int sizes[tile_kind_count + 1];
+            joined_group_sizes(tiles, x, y, sizes);
+
+            int kinds[tile_kind_count];
+            auto kind_count = 0;
+
+            for(auto kind = 1; kind <= tile_kind_count; kind += 1) {
+                if(sizes[kind] < 3) {
+                    kinds[kind_count] = kind;
+                    kind_count += 1;
+                }
+            }
+
+            tiles[y][x] = kinds[random_below(random, kind_count)];
+        }
+    }
+
+    return planted;
+}
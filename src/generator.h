@@ -0,0 +1,10 @@
+#pragma once
+
+#include "rules.h"
+
+// Builds a board without any group of 3 or more that has at least move_count scoring swaps, in
+// one pass and without throwing boards away. Each swap is planted as a pair and a lone tile of
+// the same kind a gap apart, and the rest is filled with kinds that cannot complete a group.
+// Returns how many swaps were planted, which is less than move_count only when they no longer
+// fit on the playfield.
+int generate_tiles(Tile tiles[playfield_size][playfield_size], Random *random, int move_count);
@@ -0,0 +1,102 @@
+#include "hint.h"
+#include <string.h>
+#include "solver.h"
+
+const auto hint_table_size = 16 << 20;
+
+static void run_worker(HintWorker *worker) {
+    while(true) {
+        Tile tiles[playfield_size][playfield_size];
+        uint32_t generation;
+
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+
+            while(!worker->requested && !worker->quitting) {
+                worker->wake.wait(lock);
+            }
+
+            if(worker->quitting) {
+                break;
+            }
+
+            memcpy(tiles, worker->tiles, sizeof(tiles));
+            generation = worker->generation;
+
+            worker->requested = false;
+            worker->cancelled = false;
+        }
+
+        // Refill is unknown to the player, so the hint only counts on the tiles already there
+        SolverResult result;
+        solve_best_points(tiles, nullptr, worker->depth, 1, &worker->table, &result, &worker->cancelled);
+
+        if(!worker->cancelled) {
+            worker->answer = ((uint64_t)generation << 32) | (uint32_t)(result.swap_index + 1);
+        }
+    }
+}
+
+void hint_start(HintWorker *worker, int depth) {
+    worker->depth = depth;
+
+    worker->quitting = false;
+    worker->requested = false;
+    // One ahead of the empty answer, which so never reads as ready
+    worker->generation = 1;
+
+    worker->cancelled = false;
+    worker->answer = 0;
+
+    transposition_init(&worker->table, hint_table_size);
+
+    worker->thread = std::thread(run_worker, worker);
+}
+
+void hint_stop(HintWorker *worker) {
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+
+        worker->quitting = true;
+        worker->cancelled = true;
+    }
+
+    worker->wake.notify_one();
+    worker->thread.join();
+
+    transposition_free(&worker->table);
+}
+
+void hint_request(HintWorker *worker, const Tile tiles[playfield_size][playfield_size]) {
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+
+        memcpy(worker->tiles, tiles, sizeof(worker->tiles));
+
+        worker->generation += 1;
+        worker->requested = true;
+        worker->cancelled = true;
+    }
+
+    worker->wake.notify_one();
+}
+
+void hint_cancel(HintWorker *worker) {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+
+    worker->generation += 1;
+    worker->requested = false;
+    worker->cancelled = true;
+}
+
+bool hint_ready(HintWorker *worker, int *swap_index) {
+    auto answer = worker->answer.load();
+
+    if((uint32_t)(answer >> 32) != worker->generation) {
+        return false;
+    }
+
+    *swap_index = (int)(uint32_t)answer - 1;
+
+    return true;
+}
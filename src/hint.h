@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "rules.h"
+#include "transposition.h"
+
+// Searches for hints on a thread of its own, so that a caller running once a frame only ever
+// hands over a board and later picks up the answer, and never waits on the search.
+struct HintWorker {
+    int depth;
+
+    std::thread thread;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    // Guarded by mutex
+    bool quitting;
+    bool requested;
+    Tile tiles[playfield_size][playfield_size];
+
+    // Bumped by every request and cancel, so an answer for an older board is never picked up
+    uint32_t generation;
+
+    std::atomic<bool> cancelled;
+
+    // The generation an answer was searched for in the high half, and its swap plus one below
+    std::atomic<uint64_t> answer;
+
+    TranspositionTable table;
+};
+
+void hint_start(HintWorker *worker, int depth);
+
+void hint_stop(HintWorker *worker);
+
+// Starts searching a copy of tiles, cancelling any search still running
+void hint_request(HintWorker *worker, const Tile tiles[playfield_size][playfield_size]);
+
+void hint_cancel(HintWorker *worker);
+
+// Whether the answer to the latest request is in, with -1 as the swap when nothing scores
+bool hint_ready(HintWorker *worker, int *swap_index);
@@ -0,0 +1,242 @@
+#include "lines.h"
+#include <string.h>
+#include "zobrist.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#define LINE_SSE2
+#include <emmintrin.h>
+#endif
+
+const auto row_mask = (1 << playfield_size) - 1;
+
+// Runs are found from where they start: 3 equal tiles in a row starting at x mark x, x + 1 and
+// x + 2, and likewise down columns. With SSE2 a whole row of starts is one pair of compares.
+void find_runs(const Tile tiles[playfield_size][playfield_size], uint16_t runs[playfield_size]) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        runs[y] = 0;
+    }
+
+#if defined(LINE_SSE2)
+    const auto start_mask = (1 << (playfield_size - 2)) - 1;
+
+    // Rows are loaded 16 tiles at a time, running into the next rows and then into padding
+    Tile padded[playfield_size * playfield_size + 32] {};
+    memcpy(padded, tiles, playfield_size * playfield_size * sizeof(Tile));
+
+    auto zero = _mm_setzero_si128();
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        auto row = &padded[y * playfield_size];
+
+        auto a = _mm_loadu_si128((const __m128i*)row);
+        auto b = _mm_loadu_si128((const __m128i*)(row + 1));
+        auto c = _mm_loadu_si128((const __m128i*)(row + 2));
+
+        auto same = _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c));
+        auto starts = _mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi8(a, zero), same)) & start_mask;
+
+        runs[y] |= (uint16_t)(starts | (starts << 1) | (starts << 2));
+    }
+
+    for(auto y = 0; y < playfield_size - 2; y += 1) {
+        auto row = &padded[y * playfield_size];
+
+        auto a = _mm_loadu_si128((const __m128i*)row);
+        auto b = _mm_loadu_si128((const __m128i*)(row + playfield_size));
+        auto c = _mm_loadu_si128((const __m128i*)(row + playfield_size * 2));
+
+        auto same = _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c));
+        auto starts = (uint16_t)(_mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi8(a, zero), same)) & row_mask);
+
+        runs[y] |= starts;
+        runs[y + 1] |= starts;
+        runs[y + 2] |= starts;
+    }
+#else
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto kind = tiles[y][x];
+
+            if(kind == 0) {
+                continue;
+            }
+
+            if(x < playfield_size - 2 && tiles[y][x + 1] == kind && tiles[y][x + 2] == kind) {
+                runs[y] |= (uint16_t)(7 << x);
+            }
+
+            if(y < playfield_size - 2 && tiles[y + 1][x] == kind && tiles[y + 2][x] == kind) {
+                runs[y] |= (uint16_t)(1 << x);
+                runs[y + 1] |= (uint16_t)(1 << x);
+                runs[y + 2] |= (uint16_t)(1 << x);
+            }
+        }
+    }
+#endif
+}
+
+static int run_length(const Tile tiles[playfield_size][playfield_size], int x, int y, int step_x, int step_y) {
+    auto kind = tiles[y][x];
+
+    auto length = 1;
+
+    for(auto other_x = x + step_x, other_y = y + step_y; in_playfield(other_x, other_y) && tiles[other_y][other_x] == kind; other_x += step_x, other_y += step_y) {
+        length += 1;
+    }
+
+    for(auto other_x = x - step_x, other_y = y - step_y; in_playfield(other_x, other_y) && tiles[other_y][other_x] == kind; other_x -= step_x, other_y -= step_y) {
+        length += 1;
+    }
+
+    return length;
+}
+
+bool in_run(const Tile tiles[playfield_size][playfield_size], int x, int y) {
+    if(tiles[y][x] == 0) {
+        return false;
+    }
+
+    return run_length(tiles, x, y, 1, 0) >= 3 || run_length(tiles, x, y, 0, 1) >= 3;
+}
+
+bool line_swap_scores(Tile tiles[playfield_size][playfield_size], int swap_index) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from_tile_type = tiles[from_y][from_x];
+    auto to_tile_type = tiles[to_y][to_x];
+
+    if(from_tile_type == 0 || to_tile_type == 0) {
+        return false;
+    }
+
+    tiles[from_y][from_x] = to_tile_type;
+    tiles[to_y][to_x] = from_tile_type;
+
+    auto scores = in_run(tiles, to_x, to_y) || in_run(tiles, from_x, from_y);
+
+    tiles[from_y][from_x] = from_tile_type;
+    tiles[to_y][to_x] = to_tile_type;
+
+    return scores;
+}
+
+int find_line_scoring_swaps(Tile tiles[playfield_size][playfield_size], int swap_indices[swap_count]) {
+    auto count = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        if(line_swap_scores(tiles, i)) {
+            swap_indices[count] = i;
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+void mark_potential_runs(Tile tiles[playfield_size][playfield_size], const int swap_indices[], int swap_index_count, bool potential[playfield_size][playfield_size]) {
+    memset(potential, 0, sizeof(bool) * playfield_size * playfield_size);
+
+    for(auto i = 0; i < swap_index_count; i += 1) {
+        int from_x;
+        int from_y;
+        int to_x;
+        int to_y;
+        swap_from_index(swap_indices[i], &from_x, &from_y, &to_x, &to_y);
+
+        auto from_tile_type = tiles[from_y][from_x];
+        auto to_tile_type = tiles[to_y][to_x];
+
+        tiles[from_y][from_x] = to_tile_type;
+        tiles[to_y][to_x] = from_tile_type;
+
+        uint16_t runs[playfield_size];
+        find_runs(tiles, runs);
+
+        tiles[from_y][from_x] = from_tile_type;
+        tiles[to_y][to_x] = to_tile_type;
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(((runs[y] >> x) & 1) == 0) {
+                    continue;
+                }
+
+                // The two swapped tiles came from each other's place
+                if(x == from_x && y == from_y) {
+                    potential[to_y][to_x] = true;
+                } else if(x == to_x && y == to_y) {
+                    potential[from_y][from_x] = true;
+                } else {
+                    potential[y][x] = true;
+                }
+            }
+        }
+    }
+}
+
+// Clears every tile in runs and returns how many there were
+static int clear_runs(Tile tiles[playfield_size][playfield_size], const uint16_t runs[playfield_size], uint64_t *hash) {
+    auto count = 0;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        if(runs[y] == 0) {
+            continue;
+        }
+
+        for(auto x = 0; x < playfield_size; x += 1) {
+            if((runs[y] >> x) & 1) {
+                if(hash != nullptr) {
+                    *hash ^= zobrist_key(x, y, tiles[y][x]);
+                }
+
+                tiles[y][x] = 0;
+                count += 1;
+            }
+        }
+    }
+
+    return count;
+}
+
+int clear_all_runs(Tile tiles[playfield_size][playfield_size], uint64_t *hash) {
+    uint16_t runs[playfield_size];
+    find_runs(tiles, runs);
+
+    return clear_runs(tiles, runs, hash);
+}
+
+int clear_line_swap(Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from_tile_type = tiles[from_y][from_x];
+    auto to_tile_type = tiles[to_y][to_x];
+
+    tiles[from_y][from_x] = to_tile_type;
+    tiles[to_y][to_x] = from_tile_type;
+
+    if(hash != nullptr) {
+        *hash ^= zobrist_key(from_x, from_y, from_tile_type) ^ zobrist_key(to_x, to_y, to_tile_type);
+        *hash ^= zobrist_key(from_x, from_y, to_tile_type) ^ zobrist_key(to_x, to_y, from_tile_type);
+    }
+
+    if(!in_run(tiles, to_x, to_y) && !in_run(tiles, from_x, from_y)) {
+        return 0;
+    }
+
+    return clear_all_runs(tiles, hash);
+}
+
+// Same clearing count as points and the same settle stage as the group rule
+int simulate_line_swap(Tile tiles[playfield_size][playfield_size], Random *random, int swap_index, uint64_t *hash) {
+    UniformRefill refill { random };
+    LineRule rule;
+
+    return resolve_swap(&rule, tiles, random != nullptr ? &refill : nullptr, swap_index, hash);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+#include "refill.h"
+
+// Which tiles a swap clears: any 4-connected group of 3 or more of a kind, or, as in the
+// classic game, straight horizontal and vertical runs of 3 or more
+enum struct MatchRule {
+    Groups,
+    Lines
+};
+
+static_assert(playfield_size <= 16, "Rows must fit in a 16 bit run mask");
+
+// Sets bit x of runs[y] for every tile in a horizontal or vertical run of 3 or more
+void find_runs(const Tile tiles[playfield_size][playfield_size], uint16_t runs[playfield_size]);
+
+bool in_run(const Tile tiles[playfield_size][playfield_size], int x, int y);
+
+bool line_swap_scores(Tile tiles[playfield_size][playfield_size], int swap_index);
+
+int find_line_scoring_swaps(Tile tiles[playfield_size][playfield_size], int swap_indices[swap_count]);
+
+// Tiles are marked where they are before swapping, as by mark_potential_groups
+void mark_potential_runs(Tile tiles[playfield_size][playfield_size], const int swap_indices[], int swap_index_count, bool potential[playfield_size][playfield_size]);
+
+// A swap scores when it puts either tile in a run. Then every run on the board clears.
+int clear_line_swap(Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash = nullptr);
+
+// Clears every run on the board and returns how many tiles that was
+int clear_all_runs(Tile tiles[playfield_size][playfield_size], uint64_t *hash = nullptr);
+
+// Runs clear after every settle, so with resolve_swap the board settles over and over while
+// settling lines up new runs
+struct LineRule {};
+
+static inline int clear_swap_matches(LineRule *, Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash) {
+    return clear_line_swap(tiles, swap_index, hash);
+}
+
+static inline int clear_settled_matches(LineRule *, Tile tiles[playfield_size][playfield_size], uint64_t *hash) {
+    return clear_all_runs(tiles, hash);
+}
+
+int simulate_line_swap(Tile tiles[playfield_size][playfield_size], Random *random, int swap_index, uint64_t *hash = nullptr);
+
+// Either rule picked at run time, for the game, which plays whichever it was started with
+
+static inline int simulate_rule_swap(MatchRule rule, Tile tiles[playfield_size][playfield_size], Random *random, int swap_index, uint64_t *hash = nullptr) {
+    switch(rule) {
+        case MatchRule::Groups: return simulate_swap(tiles, random, swap_index, hash);
+        case MatchRule::Lines: return simulate_line_swap(tiles, random, swap_index, hash);
+    }
+
+    return 0;
+}
+
+static inline int clear_rule_swap(MatchRule rule, Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash = nullptr) {
+    switch(rule) {
+        case MatchRule::Groups: return clear_swap_groups(tiles, swap_index, hash);
+        case MatchRule::Lines: return clear_line_swap(tiles, swap_index, hash);
+    }
+
+    return 0;
+}
+
+static inline int clear_rule_settled(MatchRule rule, Tile tiles[playfield_size][playfield_size], uint64_t *hash = nullptr) {
+    switch(rule) {
+        case MatchRule::Groups: return 0;
+        case MatchRule::Lines: return clear_all_runs(tiles, hash);
+    }
+
+    return 0;
+}
+
+static inline int find_rule_scoring_swaps(MatchRule rule, Tile tiles[playfield_size][playfield_size], int swap_indices[swap_count]) {
+    switch(rule) {
+        case MatchRule::Groups: return find_scoring_swaps(tiles, swap_indices);
+        case MatchRule::Lines: return find_line_scoring_swaps(tiles, swap_indices);
+    }
+
+    return 0;
+}
+
+static inline void mark_rule_potential(MatchRule rule, Tile tiles[playfield_size][playfield_size], const int swap_indices[], int swap_index_count, bool potential[playfield_size][playfield_size]) {
+    switch(rule) {
+        case MatchRule::Groups: mark_potential_groups(tiles, swap_indices, swap_index_count, potential); break;
+        case MatchRule::Lines: mark_potential_runs(tiles, swap_indices, swap_index_count, potential); break;
+    }
+}
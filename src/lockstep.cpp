@@ -0,0 +1,285 @@
+#include "lockstep.h"
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int lowest_lane(LaneMask lanes) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, lanes);
+
+    return (int)index;
+#else
+    return __builtin_ctzll(lanes);
+#endif
+}
+
+static LaneMask same_kind(const LaneMask a[tile_kind_bit_count], const LaneMask b[tile_kind_bit_count]) {
+    LaneMask different = 0;
+
+    for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+        different |= a[bit] ^ b[bit];
+    }
+
+    return ~different;
+}
+
+static LaneMask occupied(const LaneMask kind[tile_kind_bit_count]) {
+    LaneMask any = 0;
+
+    for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+        any |= kind[bit];
+    }
+
+    return any;
+}
+
+void lockstep_load(LockstepBoards *boards, int lane, const Tile tiles[playfield_size][playfield_size], Random random) {
+    auto lane_bit = (LaneMask)1 << lane;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+                auto set = (LaneMask)((tiles[y][x] >> bit) & 1);
+
+                boards->tiles[y][x][bit] = (boards->tiles[y][x][bit] & ~lane_bit) | (set << lane);
+            }
+        }
+    }
+
+    boards->random_states[lane] = random.state;
+    boards->points[lane] = 0;
+}
+
+int lockstep_tile(const LockstepBoards *boards, int lane, int x, int y) {
+    auto kind = 0;
+
+    for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+        kind |= (int)((boards->tiles[y][x][bit] >> lane) & 1) << bit;
+    }
+
+    return kind;
+}
+
+void lockstep_store(const LockstepBoards *boards, int lane, Tile tiles[playfield_size][playfield_size], Random *random) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            tiles[y][x] = lockstep_tile(boards, lane, x, y);
+        }
+    }
+
+    random->state = boards->random_states[lane];
+}
+
+// Tracks, per lane, whether a group has reached one, two and three or more tiles
+struct GroupSizes {
+    LaneMask at_least_one;
+    LaneMask at_least_two;
+    LaneMask at_least_three;
+};
+
+static void add_to_group_sizes(GroupSizes *sizes, LaneMask lanes) {
+    sizes->at_least_three |= sizes->at_least_two & lanes;
+    sizes->at_least_two |= sizes->at_least_one & lanes;
+    sizes->at_least_one |= lanes;
+}
+
+// Floods the seeded cells out to their whole same-kind groups, sweeping the board until no
+// lane changes. Growth carries along with each sweep, so the small groups a swap makes
+// settle after two or three sweeps.
+static void grow_groups(LaneMask groups[playfield_size][playfield_size], const LaneMask same_right[playfield_size][playfield_size], const LaneMask same_below[playfield_size][playfield_size]) {
+    while(true) {
+        LaneMask changed = 0;
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                auto grown = groups[y][x];
+
+                if(x + 1 < playfield_size) {
+                    grown |= groups[y][x + 1] & same_right[y][x];
+                }
+
+                if(y + 1 < playfield_size) {
+                    grown |= groups[y + 1][x] & same_below[y][x];
+                }
+
+                if(x > 0) {
+                    grown |= groups[y][x - 1] & same_right[y][x - 1];
+                }
+
+                if(y > 0) {
+                    grown |= groups[y - 1][x] & same_below[y - 1][x];
+                }
+
+                changed |= grown ^ groups[y][x];
+                groups[y][x] = grown;
+            }
+        }
+
+        if(changed == 0) {
+            break;
+        }
+    }
+}
+
+static void settle_column(LockstepBoards *boards, int x) {
+    auto lowest_empty_y = -1;
+
+    for(auto y = playfield_size - 1; y >= 0; y -= 1) {
+        if(~occupied(boards->tiles[y][x]) != 0) {
+            lowest_empty_y = y;
+
+            break;
+        }
+    }
+
+    if(lowest_empty_y == -1) {
+        return;
+    }
+
+    // Each pass moves every tile with a gap below it down by one
+    while(true) {
+        LaneMask moved = 0;
+
+        for(auto y = lowest_empty_y; y > 0; y -= 1) {
+            auto below = boards->tiles[y][x];
+            auto above = boards->tiles[y - 1][x];
+
+            auto falling = ~occupied(below) & occupied(above);
+
+            for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+                below[bit] |= above[bit] & falling;
+                above[bit] &= ~falling;
+            }
+
+            moved |= falling;
+        }
+
+        if(moved == 0) {
+            break;
+        }
+    }
+
+    // Gravity leaves every empty tile at the top of its column, so visiting rows top down
+    // draws kinds in the same order as settle_tiles
+    for(auto y = 0; y <= lowest_empty_y; y += 1) {
+        auto kind = boards->tiles[y][x];
+
+        auto empty = ~occupied(kind);
+
+        if(empty == 0) {
+            break;
+        }
+
+        while(empty != 0) {
+            auto lane = lowest_lane(empty);
+
+            empty &= empty - 1;
+
+            boards->random_states[lane] = step_random_state(boards->random_states[lane]);
+
+            auto new_kind = tile_kind_from_random(boards->random_states[lane]);
+
+            for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+                kind[bit] |= (LaneMask)((new_kind >> bit) & 1) << lane;
+            }
+        }
+    }
+}
+
+void lockstep_simulate_swaps(LockstepBoards *boards, const int swap_indices[lockstep_lane_count]) {
+    LaneMask groups[playfield_size][playfield_size];
+    memset(groups, 0, sizeof(groups));
+
+    // Kind of the tile each lane swapped into its target, which tells the two groups apart
+    LaneMask to_kind[tile_kind_bit_count] {};
+
+    for(auto lane = 0; lane < lockstep_lane_count; lane += 1) {
+        auto lane_bit = (LaneMask)1 << lane;
+
+        int from_x;
+        int from_y;
+        int to_x;
+        int to_y;
+        swap_from_index(swap_indices[lane], &from_x, &from_y, &to_x, &to_y);
+
+        auto from_tile = boards->tiles[from_y][from_x];
+        auto to_tile = boards->tiles[to_y][to_x];
+
+        LaneMask different = 0;
+
+        for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+            auto flip = (from_tile[bit] ^ to_tile[bit]) & lane_bit;
+
+            from_tile[bit] ^= flip;
+            to_tile[bit] ^= flip;
+
+            to_kind[bit] |= to_tile[bit] & lane_bit;
+
+            different |= flip;
+        }
+
+        groups[to_y][to_x] |= lane_bit;
+
+        // A swap of two equal kinds only has one group to score, as in simulate_swap
+        groups[from_y][from_x] |= different;
+    }
+
+    LaneMask same_right[playfield_size][playfield_size];
+    LaneMask same_below[playfield_size][playfield_size];
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            if(x + 1 < playfield_size) {
+                same_right[y][x] = same_kind(boards->tiles[y][x], boards->tiles[y][x + 1]);
+            }
+
+            if(y + 1 < playfield_size) {
+                same_below[y][x] = same_kind(boards->tiles[y][x], boards->tiles[y + 1][x]);
+            }
+        }
+    }
+
+    // Both groups of a lane grow in the same mask, since groups of different kinds never merge
+    grow_groups(groups, same_right, same_below);
+
+    GroupSizes to_sizes {};
+    GroupSizes from_sizes {};
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto to_group = groups[y][x] & same_kind(boards->tiles[y][x], to_kind);
+
+            add_to_group_sizes(&to_sizes, to_group);
+            add_to_group_sizes(&from_sizes, groups[y][x] & ~to_group);
+        }
+    }
+
+    auto clear_to = to_sizes.at_least_three;
+    auto clear_from = from_sizes.at_least_three;
+
+    if((clear_to | clear_from) == 0) {
+        return;
+    }
+
+    // Every cleared tile scores a point for its lane
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            auto to_group = groups[y][x] & same_kind(boards->tiles[y][x], to_kind);
+            auto cleared = (to_group & clear_to) | (groups[y][x] & ~to_group & clear_from);
+
+            for(auto bit = 0; bit < tile_kind_bit_count; bit += 1) {
+                boards->tiles[y][x][bit] &= ~cleared;
+            }
+
+            for(; cleared != 0; cleared &= cleared - 1) {
+                boards->points[lowest_lane(cleared)] += 1;
+            }
+        }
+    }
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        settle_column(boards, x);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// Boards are bit-sliced: bit i of every LaneMask belongs to board i, so each rule stage is
+// a handful of word-wide logic operations that advance all lanes at once.
+typedef uint64_t LaneMask;
+
+const auto lockstep_lane_count = 64;
+
+// Tile kinds 1..tile_kind_count, with 0 as the empty tile, in binary
+const auto tile_kind_bit_count = 3;
+
+static_assert(tile_kind_count < (1 << tile_kind_bit_count), "Tile kinds must fit in tile_kind_bit_count bits");
+
+struct LockstepBoards {
+    LaneMask tiles[playfield_size][playfield_size][tile_kind_bit_count];
+
+    uint32_t random_states[lockstep_lane_count];
+
+    int32_t points[lockstep_lane_count];
+};
+
+void lockstep_load(LockstepBoards *boards, int lane, const Tile tiles[playfield_size][playfield_size], Random random);
+
+void lockstep_store(const LockstepBoards *boards, int lane, Tile tiles[playfield_size][playfield_size], Random *random);
+
+int lockstep_tile(const LockstepBoards *boards, int lane, int x, int y);
+
+// Applies swap_indices[lane] to every board, exactly as simulate_swap would, and adds the
+// points scored to boards->points.
+void lockstep_simulate_swaps(LockstepBoards *boards, const int swap_indices[lockstep_lane_count]);
@@ -1,41 +1,70 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "raylib.h"
 #include "list.h"
+#include "rules.h"
+#include "mcts.h"
+#include "solver.h"
+#include "hint.h"
+#include "generator.h"
+#include "refill.h"
+#include "lines.h"
+#include "snapshot.h"
+#include "zobrist.h"
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "tweens.h"
+#include "events.h"
+#include "visuals.h"
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
+#else
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
 #endif
 
 static double RandomUniform() {
     return (double)rand() / RAND_MAX;
 }
 
-const int tile_kind_count = 6;
+// What the latency mode times, from the input event that caused it to the first frame showing it
+enum struct LatencyMarkKind {
+    DragStart,
+    Release,
+    Swap
+};
+
+const char *latency_mark_names[] = { "drag_start", "release", "swap" };
 
-const auto playfield_size = 10;
+struct LatencyMark {
+    LatencyMarkKind kind;
 
-static bool in_playfield(int x, int y) {
-    return x >= 0 && y >= 0 && x < playfield_size && y < playfield_size;
-}
+    double event_time;
 
-struct Particle {
-    double creation_time;
-    double lifetime;
+    // Marks are numbered in the order they are made, so drawing can tell the ones it has seen
+    uint64_t number;
+};
 
-    Color color;
+// Marks waiting for a drawn frame to show them, which is far more than input ever makes between
+// two frames
+const auto max_latency_marks = 16;
 
-    float x;
-    float y;
+// Number of the first mark that no drawn frame has shown yet, handed back by drawing. Updates
+// can outpace drawing, and not every snapshot gets drawn, so marks are carried from snapshot to
+// snapshot until one that shows them has been.
+std::atomic<uint64_t> latency_marks_drawn { 0 };
 
-    float velocity_x;
-    float velocity_y;
-};
+// Which refill policy the game plays with, chosen here at compile time
+typedef UniformRefill GameRefill;
 
 struct GameState {
-    List<Particle> particles {};
-
-    int tiles[playfield_size][playfield_size];
+    Tile tiles[playfield_size][playfield_size];
+    uint64_t tiles_hash;
 
     bool dragging = false;
     int drag_start_mouse_x;
@@ -43,50 +72,321 @@ struct GameState {
     int drag_start_tile_x;
     int drag_start_tile_y;
 
+    // Where the mouse was as of the last input event
+    int mouse_x;
+    int mouse_y;
+
     struct FallingTile {
         int x;
 
         int start_y;
         int end_y;
 
-        int kind;
+        Tile kind;
+    };
+
+    // What has happened in the game, and how far drawing has played it out
+    GameEventRing events;
+    uint64_t visuals_cursor = 0;
+
+    // Every animation is a tween in here, and the visual entities hold their slots. The board is
+    // settling for as long as any tiles are clearing or falling.
+    Tweens tweens;
+    Visuals visuals;
+
+    // Everything a swap will do, worked out before it happens
+    struct SwapPlan {
+        // The board the plan was made for
+        uint64_t tiles_hash;
+
+        int from_x;
+        int from_y;
+        int to_x;
+        int to_y;
+
+        int points;
+
+        // Kinds of the tiles the swap clears, after swapping, and 0 for the ones it leaves
+        Tile cleared[playfield_size][playfield_size];
+
+        // Tiles that fall into place, apart from the new ones refill drops in from above
+        List<FallingTile> falling_tiles;
+
+        // The board once everything has fallen, with the tiles still to be refilled empty
+        Tile settled[playfield_size][playfield_size];
+        uint64_t settled_hash;
     };
 
-    bool falling = false;
-    List<FallingTile> falling_tiles {};
-    float falling_velocity;
-    float falling_amount;
+    // Plans for the swap in each direction from the dragged tile, made while dragging, so that
+    // releasing only has to carry one out
+    SwapPlan swap_plans[4];
+
+    // Which tiles swaps clear, chosen when the game starts
+    MatchRule rule = MatchRule::Groups;
+
+    // With the line rule settling can line up new runs, which clear in turn, planned in here
+    SwapPlan cascade_plan;
+
+    // Where the dragged tile is headed, how far it has moved on screen and the plan for swapping
+    // it there, worked out on every update
+    int drag_target_tile_x;
+    int drag_target_tile_y;
+    int drag_offset_screen_x;
+    int drag_offset_screen_y;
+    SwapPlan *drag_plan = nullptr;
+
+    // Refill kinds come from here, as does the opening board
+    Random random;
+    GameRefill refill;
 
     int points = 0;
     int displayed_points = 0;
-    double last_displayed_points_tick;
+
+    // Counts the displayed points toward the points from where they were when it started
+    int points_tween = -1;
+    int points_tween_from;
+
+    // Boards from before each swap, most recent last, for undo
+    List<BoardSnapshot> undo_snapshots {};
+
+    bool demo = false;
+    bool demo_player_ready = false;
+    MctsPlayer demo_player;
+    int demo_last_swap;
+
+    // Tiles that some swap would bring into a group or run, worked out again whenever the board settles
+    // into a new position, so drawing only has to look them up
+    bool glow = false;
+    bool potential_groups[playfield_size][playfield_size];
+    uint64_t potential_groups_hash;
+
+    bool hint_worker_ready = false;
+    HintWorker hint_worker;
+    bool hint_pending = false;
+    int hint_swap = -1;
+
+    // Marks that no drawn frame has shown yet, handed on with every snapshot until one has
+    int latency_mark_count = 0;
+    LatencyMark latency_marks[max_latency_marks];
+    uint64_t latency_mark_number = 0;
+};
+
+enum struct InputEventKind {
+    MousePressed,
+    MouseReleased,
+    MouseMoved,
+    ToggleDemo,
+    Undo,
+    ToggleGlow,
+    Hint
+};
+
+// Something the player did, when it happened in GetTime seconds and where the mouse was then
+struct InputEvent {
+    InputEventKind kind;
+
+    double time;
+
+    int mouse_x;
+    int mouse_y;
 };
 
-static int count_neighbours(GameState state, bool counted[playfield_size][playfield_size], int x, int y, int kind) {
-    counted[y][x] = true;
+const auto input_queue_capacity = 256;
+
+// Only the main thread may read input from the window. It pushes events here in the order they
+// happened, and updates take them, on the main thread or the simulation thread alike.
+SpscQueue<InputEvent, input_queue_capacity> input_queue;
+
+// Moves only ever fill the queue up to this much short of full, so a stall that floods it with
+// them still leaves room for the presses, releases and keys that change what the game does
+const auto input_queue_headroom = 64;
+
+static void push_input_event(InputEventKind kind, double time, int mouse_x, int mouse_y) {
+    if(kind == InputEventKind::MouseMoved && spsc_count(&input_queue) >= input_queue_capacity - input_queue_headroom) {
+        return;
+    }
+
+    // A full queue means updates have stalled for a long while, and dropping input is all there is to do
+    spsc_push(&input_queue, { kind, time, mouse_x, mouse_y });
+}
+
+#if !defined(PLATFORM_WEB)
+// Mouse input comes straight from GLFW callbacks, run ahead of raylib's own, so a press and
+// release within one frame are both seen, and each has its own time and position
+GLFWmousebuttonfun raylib_mouse_button_callback;
+GLFWcursorposfun raylib_cursor_position_callback;
+
+// Cursor moves are coalesced, keeping only the latest, which is pushed ahead of the next button
+// event or at the end of the poll. A 1 kHz mouse then pushes one move per burst, not one per
+// millisecond.
+struct PendingMove {
+    bool pending;
+
+    double time;
+
+    int mouse_x;
+    int mouse_y;
+};
+
+PendingMove pending_move {};
+
+static void flush_pending_move() {
+    if(pending_move.pending) {
+        pending_move.pending = false;
+
+        push_input_event(InputEventKind::MouseMoved, pending_move.time, pending_move.mouse_x, pending_move.mouse_y);
+    }
+}
+
+static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+    if(button == GLFW_MOUSE_BUTTON_LEFT && (action == GLFW_PRESS || action == GLFW_RELEASE)) {
+        double x;
+        double y;
+        glfwGetCursorPos(window, &x, &y);
+
+        flush_pending_move();
+
+        auto kind = action == GLFW_PRESS ? InputEventKind::MousePressed : InputEventKind::MouseReleased;
+
+        push_input_event(kind, GetTime(), (int)x, (int)y);
+    }
+
+    if(raylib_mouse_button_callback != nullptr) {
+        raylib_mouse_button_callback(window, button, action, mods);
+    }
+}
+
+static void cursor_position_callback(GLFWwindow *window, double x, double y) {
+    pending_move = { true, GetTime(), (int)x, (int)y };
+
+    if(raylib_cursor_position_callback != nullptr) {
+        raylib_cursor_position_callback(window, x, y);
+    }
+}
+
+static void hook_mouse_input() {
+    auto window = glfwGetCurrentContext();
+
+    raylib_mouse_button_callback = glfwSetMouseButtonCallback(window, mouse_button_callback);
+    raylib_cursor_position_callback = glfwSetCursorPosCallback(window, cursor_position_callback);
+}
+#else
+int polled_mouse_x;
+int polled_mouse_y;
+#endif
+
+// Reads the input that does not arrive through callbacks, once a frame
+static void poll_input() {
+    auto time = GetTime();
+
+#if !defined(PLATFORM_WEB)
+    flush_pending_move();
+#endif
+
+    auto mouse_x = GetMouseX();
+    auto mouse_y = GetMouseY();
+
+#if defined(PLATFORM_WEB)
+    if(mouse_x != polled_mouse_x || mouse_y != polled_mouse_y) {
+        polled_mouse_x = mouse_x;
+        polled_mouse_y = mouse_y;
+
+        push_input_event(InputEventKind::MouseMoved, time, mouse_x, mouse_y);
+    }
+
+    if(IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        push_input_event(InputEventKind::MousePressed, time, mouse_x, mouse_y);
+    }
+
+    if(IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+        push_input_event(InputEventKind::MouseReleased, time, mouse_x, mouse_y);
+    }
+#endif
 
-    auto total = 1;
+    if(IsKeyPressed(KEY_D)) {
+        push_input_event(InputEventKind::ToggleDemo, time, mouse_x, mouse_y);
+    }
 
-    if(in_playfield(x + 1, y) && state.tiles[y][x + 1] == kind && !counted[y][x + 1]) {
-        total += count_neighbours(state, counted, x + 1, y, kind);
+    if(IsKeyPressed(KEY_U)) {
+        push_input_event(InputEventKind::Undo, time, mouse_x, mouse_y);
     }
 
-    if(in_playfield(x, y + 1) && state.tiles[y + 1][x] == kind && !counted[y + 1][x]) {
-        total += count_neighbours(state, counted, x, y + 1, kind);
+    if(IsKeyPressed(KEY_G)) {
+        push_input_event(InputEventKind::ToggleGlow, time, mouse_x, mouse_y);
     }
 
-    if(in_playfield(x - 1, y) && state.tiles[y][x - 1] == kind && !counted[y][x - 1]) {
-        total += count_neighbours(state, counted, x - 1, y, kind);
+    if(IsKeyPressed(KEY_H)) {
+        push_input_event(InputEventKind::Hint, time, mouse_x, mouse_y);
     }
+}
+
+// Takes every event pushed so far, oldest first
+static int take_input_events(InputEvent events[input_queue_capacity]) {
+    auto count = 0;
 
-    if(in_playfield(x, y - 1) && state.tiles[y - 1][x] == kind && !counted[y - 1][x]) {
-        total += count_neighbours(state, counted, x, y - 1, kind);
+    while(count < input_queue_capacity && spsc_pop(&input_queue, &events[count])) {
+        count += 1;
     }
 
-    return total;
+    return count;
+}
+
+const auto max_drawn_visuals = 1536;
+
+// Everything drawing needs from one moment of the game, copied out so that drawing never reads
+// state that the simulation is changing
+struct RenderSnapshot {
+    Tile tiles[playfield_size][playfield_size];
+
+    bool dragging;
+    int drag_start_tile_x;
+    int drag_start_tile_y;
+    int drag_target_tile_x;
+    int drag_target_tile_y;
+    int drag_offset_screen_x;
+    int drag_offset_screen_y;
+
+    // Tiles the dragged swap would clear, when there is a swap to preview
+    bool drag_preview;
+    Tile drag_cleared[playfield_size][playfield_size];
+
+    bool glow;
+    bool potential_groups[playfield_size][playfield_size];
+
+    int hint_swap;
+
+    // Visual entities in the order they are drawn in, in tiles from the top left of the board
+    struct DrawnVisual {
+        float x;
+        float y;
+        float scale;
+
+        VisualShape shape;
+        Tile kind;
+
+        int number;
+    };
+
+    int visual_count;
+    DrawnVisual visuals[max_drawn_visuals];
+
+    int displayed_points;
+    bool demo;
+
+    int latency_mark_count;
+    LatencyMark latency_marks[max_latency_marks];
+};
+
+static void add_latency_mark(GameState *state, LatencyMarkKind kind, double event_time) {
+    if(state->latency_mark_count < max_latency_marks) {
+        state->latency_marks[state->latency_mark_count] = { kind, event_time, state->latency_mark_number };
+        state->latency_mark_count += 1;
+
+        state->latency_mark_number += 1;
+    }
 }
 
-static Color tile_color(int kind) {
+static Color tile_color(Tile kind) {
     switch(kind) {
         case 1: return RED; break;
         case 2: return GREEN; break;
@@ -98,37 +398,155 @@ static Color tile_color(int kind) {
     }
 }
 
-static void delete_neighbours(GameState *state, double time, int x, int y, int kind) {
-    state->tiles[y][x] = 0;
+static bool board_settling(const GameState *state) {
+    return state->visuals.settling.count != 0;
+}
+
+// When the last tile now clearing or falling is done, or time if that is sooner
+static double settled_time(const GameState *state, double time) {
+    auto visuals = &state->visuals;
+
+    auto end_time = time;
+
+    for(auto i = 0; i < visuals->settling.count; i += 1) {
+        auto slot = visuals->lifetimes.slots[visuals->settling.owners[i]];
+
+        if(slot != -1) {
+            auto tween_end = tween_end_time(&state->tweens, visuals->lifetimes.values[slot].tween);
+
+            if(tween_end > end_time) {
+                end_time = tween_end;
+            }
+        }
+    }
+
+    return end_time;
+}
+
+// Cleared tiles shrink away where they were. Like every visual below, they are only for show,
+// and are left out when there are no entities or tweens to spare.
+static void add_clearing_tile(GameState *state, double start_time, double duration, int x, int y, Tile kind) {
+    auto visuals = &state->visuals;
+
+    auto entity = visual_create(visuals);
+    if(entity.index == -1) {
+        return;
+    }
+
+    auto tween = tween_add(&state->tweens, start_time, duration, 1, 0, Easing::EaseIn);
+    if(tween == -1) {
+        visual_destroy(visuals, &state->tweens, entity);
+
+        return;
+    }
+
+    component_set(&visuals->placements, entity, { (float)x, (float)y, 1, -1, -1, tween, false, true });
+    component_set(&visuals->appearances, entity, { VisualShape::ShrinkingTile, kind, 0 });
+    component_set(&visuals->lifetimes, entity, { tween });
+    component_set(&visuals->settling, entity, { x, y });
+}
+
+// Particles fly in a straight line until their time is up, as a tween for each coordinate
+static void add_tile_particles(GameState *state, double start_time, int x, int y, Tile kind) {
+    auto visuals = &state->visuals;
 
     for(auto i = 0; i < 3; i += 1) {
         auto angle = (float)RandomUniform() * PI * 2;
 
-        append(&state->particles, {
-            time,
-            0.3 + RandomUniform() * 0.2,
-            tile_color(kind),
-            x + 0.5f + (float)RandomUniform() * 0.6f - 0.3f,
-            y + 0.5f + (float)RandomUniform() * 0.6f - 0.3f,
-            cosf(angle) * 5,
-            sinf(angle) * 5
-        });
+        auto lifetime = 0.3 + RandomUniform() * 0.2;
+
+        auto start_x = x + 0.5f + (float)RandomUniform() * 0.6f - 0.3f;
+        auto start_y = y + 0.5f + (float)RandomUniform() * 0.6f - 0.3f;
+
+        auto end_x = start_x + cosf(angle) * 5 * (float)lifetime;
+        auto end_y = start_y + sinf(angle) * 5 * (float)lifetime;
+
+        auto entity = visual_create(visuals);
+        if(entity.index == -1) {
+            return;
+        }
+
+        Placement placement { start_x, start_y, 1, -1, -1, -1, true, false };
+        placement.x_tween = tween_add(&state->tweens, start_time, lifetime, start_x, end_x, Easing::Linear);
+        placement.y_tween = tween_add(&state->tweens, start_time, lifetime, start_y, end_y, Easing::Linear);
+
+        // The entity owns whichever tweens it got as soon as it has its placement
+        component_set(&visuals->placements, entity, placement);
+
+        if(placement.x_tween == -1 || placement.y_tween == -1) {
+            visual_destroy(visuals, &state->tweens, entity);
+
+            return;
+        }
+
+        component_set(&visuals->appearances, entity, { VisualShape::Particle, kind, 0 });
+        component_set(&visuals->lifetimes, entity, { placement.x_tween });
+    }
+}
+
+static void add_falling_tile(GameState *state, double start_time, GameState::FallingTile tile) {
+    auto visuals = &state->visuals;
+
+    auto entity = visual_create(visuals);
+    if(entity.index == -1) {
+        return;
+    }
+
+    auto distance = (float)(tile.end_y - tile.start_y);
+
+    // Without a tween the tile is simply shown where it already is on the board
+    auto tween = tween_add(&state->tweens, start_time, fall_duration(distance), (float)tile.start_y, (float)tile.end_y, Easing::EaseIn);
+    if(tween == -1) {
+        visual_destroy(visuals, &state->tweens, entity);
+
+        return;
     }
 
-    if(in_playfield(x + 1, y) && state->tiles[y][x + 1] == kind) {
-        delete_neighbours(state, time, x + 1, y, kind);
+    component_set(&visuals->placements, entity, { (float)tile.x, (float)tile.start_y, 1, -1, tween, -1, false, true });
+    component_set(&visuals->appearances, entity, { VisualShape::FullTile, tile.kind, 0 });
+    component_set(&visuals->lifetimes, entity, { tween });
+    component_set(&visuals->settling, entity, { tile.x, tile.end_y });
+}
+
+// Points for a group rise from its middle as they are scored
+static void add_points_popup(GameState *state, double start_time, float x, float y, int points) {
+    auto visuals = &state->visuals;
+
+    auto entity = visual_create(visuals);
+    if(entity.index == -1) {
+        return;
     }
 
-    if(in_playfield(x, y + 1) && state->tiles[y + 1][x] == kind) {
-        delete_neighbours(state, time, x, y + 1, kind);
+    const auto popup_time = 0.6;
+    const auto popup_rise = 0.75f;
+
+    auto tween = tween_add(&state->tweens, start_time, popup_time, y, y - popup_rise, Easing::EaseOut);
+    if(tween == -1) {
+        visual_destroy(visuals, &state->tweens, entity);
+
+        return;
     }
 
-    if(in_playfield(x - 1, y) && state->tiles[y][x - 1] == kind) {
-        delete_neighbours(state, time, x - 1, y, kind);
+    component_set(&visuals->placements, entity, { x, y, 1, -1, tween, -1, false, true });
+    component_set(&visuals->appearances, entity, { VisualShape::Popup, 0, points });
+    component_set(&visuals->lifetimes, entity, { tween });
+}
+
+const auto displayed_points_tick_time = 0.05;
+
+// The displayed points count one per tick toward the points, from wherever they are now
+static void start_points_ticker(GameState *state, double time) {
+    if(state->points_tween != -1) {
+        tween_release(&state->tweens, state->points_tween);
     }
 
-    if(in_playfield(x, y - 1) && state->tiles[y - 1][x] == kind) {
-        delete_neighbours(state, time, x, y - 1, kind);
+    auto difference = abs(state->points - state->displayed_points);
+
+    state->points_tween_from = state->displayed_points;
+    state->points_tween = tween_add(&state->tweens, time, difference * displayed_points_tick_time, (float)state->displayed_points, (float)state->points, Easing::Linear);
+
+    if(state->points_tween == -1) {
+        state->displayed_points = state->points;
     }
 }
 
@@ -184,250 +602,743 @@ static void tile_to_screen(int tile_x, int tile_y, int *x, int *y) {
 
 const auto tile_inset = 2;
 
-static void draw_tile_at(int x, int y, int kind) {
+static void draw_tile_at(int x, int y, Tile kind) {
     auto color = tile_color(kind);
 
     DrawRectangle(x + tile_inset, y + tile_inset, tile_size - tile_inset * 2, tile_size - tile_inset * 2, color);
 }
 
-static void gameplay_loop(GameState *state) {
-    const auto displayed_points_tick_time = 0.05;
-
-    auto time = GetTime();
-    auto delta_time = GetFrameTime();
-
-    auto mouse_x = GetMouseX();
-    auto mouse_y = GetMouseY();
-
-    int mouse_tile_x;
-    int mouse_tile_y;
-    screen_to_tile(mouse_x, mouse_y, &mouse_tile_x, &mouse_tile_y);
+static void cancel_hint(GameState *state) {
+    if(state->hint_worker_ready) {
+        hint_cancel(&state->hint_worker);
+    }
 
-    if(state->last_displayed_points_tick + displayed_points_tick_time <= time) {
-        state->last_displayed_points_tick = time;
+    state->hint_pending = false;
+    state->hint_swap = -1;
+}
 
-        if(state->points > state->displayed_points) {
-            state->displayed_points += 1;
-        } else if(state->points < state->displayed_points) {
-            state->displayed_points -= 1;
+// Fills in a plan from the board before and after clearing: which tiles cleared, which fall
+// where and the board they settle into, with after_hash the hash of the board after clearing
+static void plan_settling(GameState::SwapPlan *plan, const Tile before[playfield_size][playfield_size], const Tile after[playfield_size][playfield_size], uint64_t after_hash) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            plan->cleared[y][x] = after[y][x] == 0 ? before[y][x] : 0;
         }
     }
 
-    if(state->falling) {
-        state->falling_velocity += 100.0f * delta_time;
-        state->falling_amount += state->falling_velocity * delta_time;
+    plan->falling_tiles.count = 0;
 
-        for(size_t i = 0; i < state->falling_tiles.count; i += 1) {
-            auto tile = state->falling_tiles[i];
+    if(plan->points == 0) {
+        return;
+    }
 
-            auto falling_y = tile.start_y + state->falling_amount;
+    for(auto x = 0; x < playfield_size; x += 1) {
+        auto space_count = 0;
 
-            if(falling_y >= tile.end_y) {
-                state->tiles[tile.end_y][tile.x] = tile.kind;
+        for(auto offset_y = 0; offset_y <= playfield_size - 1; offset_y += 1) {
+            auto y = playfield_size - 1 - offset_y;
 
-                remove_at(&state->falling_tiles, i);
-                i -= 1;
-            }
-        }
+            auto kind = after[y][x];
 
-        if(state->falling_tiles.count == 0) {
-            state->falling = false;
+            if(kind == 0) {
+                space_count += 1;
+            } else if(space_count > 0) {
+                append(&plan->falling_tiles, { x, y, y + space_count, kind });
+            }
         }
     }
 
-    for(size_t i = 0; i < state->particles.count; i += 1) {
-        auto particle = &state->particles[i];
+    memcpy(plan->settled, after, sizeof(plan->settled));
+    plan->settled_hash = after_hash;
 
-        if(particle->creation_time + particle->lifetime <= time) {
-            remove_at(&state->particles, i);
-            i -= 1;
-        } else {
-            particle->x += particle->velocity_x * delta_time;
-            particle->y += particle->velocity_y * delta_time;
-        }
-    }
+    settle_tiles(plan->settled, nullptr, &plan->settled_hash);
+}
 
-    if(IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !state->dragging && !state->falling) {
-        if(in_playfield(mouse_tile_x, mouse_tile_y)) {
-            state->dragging = true;
-            state->drag_start_mouse_x = mouse_x;
-            state->drag_start_mouse_y = mouse_y;
-            state->drag_start_tile_x = mouse_tile_x;
-            state->drag_start_tile_y = mouse_tile_y;
-        }
+static GameState::SwapPlan *speculate_swap(GameState *state, int from_x, int from_y, int to_x, int to_y) {
+    int direction;
+    if(to_x > from_x) {
+        direction = 0;
+    } else if(to_x < from_x) {
+        direction = 1;
+    } else if(to_y > from_y) {
+        direction = 2;
+    } else {
+        direction = 3;
     }
 
-    int drag_difference_x;
-    int drag_difference_y;
-    if(state->dragging) {
-        drag_difference_x = mouse_x - state->drag_start_mouse_x;
-        drag_difference_y = mouse_y - state->drag_start_mouse_y;
+    auto plan = &state->swap_plans[direction];
+
+    if(
+        plan->tiles_hash == state->tiles_hash &&
+        plan->from_x == from_x && plan->from_y == from_y &&
+        plan->to_x == to_x && plan->to_y == to_y
+    ) {
+        return plan;
     }
 
-    if(IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && state->dragging) {
-        state->dragging = false;
+    plan->tiles_hash = state->tiles_hash;
+    plan->from_x = from_x;
+    plan->from_y = from_y;
+    plan->to_x = to_x;
+    plan->to_y = to_y;
 
-        const auto fuzzy_delta = tile_size / 4;
+    Tile tiles[playfield_size][playfield_size];
+    memcpy(tiles, state->tiles, sizeof(tiles));
 
-        auto swapping = false;
-        int drag_target_tile_x;
-        int drag_target_tile_y;
-        if(abs(drag_difference_x) > abs(drag_difference_y)) {
-            if(abs(drag_difference_x) >= tile_size - fuzzy_delta) {
-                swapping = true;
+    auto hash = state->tiles_hash;
 
-                if(drag_difference_x > 0) {
-                    drag_target_tile_x = state->drag_start_tile_x + 1;
-                } else {
-                    drag_target_tile_x = state->drag_start_tile_x - 1;
-                }
-                drag_target_tile_y = state->drag_start_tile_y;
-            }
-        } else {
-            if(abs(drag_difference_y) >= tile_size - fuzzy_delta) {
-                swapping = true;
-
-                drag_target_tile_x = state->drag_start_tile_x;
-                if(drag_difference_y > 0) {
-                    drag_target_tile_y = state->drag_start_tile_y + 1;
-                } else {
-                    drag_target_tile_y = state->drag_start_tile_y - 1;
+    plan->points = clear_rule_swap(state->rule, tiles, swap_index_between(from_x, from_y, to_x, to_y), &hash);
+
+    Tile swapped[playfield_size][playfield_size];
+    memcpy(swapped, state->tiles, sizeof(swapped));
+
+    swapped[from_y][from_x] = state->tiles[to_y][to_x];
+    swapped[to_y][to_x] = state->tiles[from_y][from_x];
+
+    plan_settling(plan, swapped, tiles, hash);
+
+    return plan;
+}
+
+// Scores a plan's cleared tiles and moves the board to where it settles
+static void commit_clear(GameState *state, double time, const GameState::SwapPlan *plan) {
+    state->points += plan->points;
+
+    GameEvent score_event { GameEventKind::ScoreChanged, time };
+    score_event.score = { plan->points, state->points };
+    emit_event(&state->events, score_event);
+
+    // Each kind cleared is one group, as a swap clears at most one group through each tile, and
+    // runs of one kind are shown together
+    for(auto kind = 1; kind <= tile_kind_count; kind += 1) {
+        GameEvent group_event { GameEventKind::GroupCleared, time };
+        group_event.group = { (Tile)kind, 0, { 0, 0 } };
+
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(plan->cleared[y][x] == kind) {
+                    auto cell = y * playfield_size + x;
+
+                    group_event.group.cells[cell / 64] |= (uint64_t)1 << (cell % 64);
+                    group_event.group.size += 1;
                 }
             }
         }
 
-        if(swapping && in_playfield(drag_target_tile_x, drag_target_tile_y)) {
-            auto from_tile_type = state->tiles[state->drag_start_tile_y][state->drag_start_tile_x];
-            auto to_tile_type = state->tiles[drag_target_tile_y][drag_target_tile_x];
+        if(group_event.group.size != 0) {
+            emit_event(&state->events, group_event);
+        }
+    }
 
-            state->tiles[state->drag_start_tile_y][state->drag_start_tile_x] = to_tile_type;
-            state->tiles[drag_target_tile_y][drag_target_tile_x] = from_tile_type;
+    for(size_t i = 0; i < plan->falling_tiles.count; i += 1) {
+        auto tile = plan->falling_tiles.elements[i];
 
-            bool counted[playfield_size][playfield_size] {};
+        GameEvent fall_event { GameEventKind::TileFell, time };
+        fall_event.tile = { (int8_t)tile.x, (int8_t)tile.start_y, (int8_t)tile.end_y, tile.kind };
+        emit_event(&state->events, fall_event);
+    }
 
-            auto to_count = count_neighbours(*state, counted, drag_target_tile_x, drag_target_tile_y, from_tile_type);
+    // The board moves straight to where it settles, refilled, while drawing catches up from the
+    // events. Refill only draws for swaps that are made, so previews never use up the random stream.
+    memcpy(state->tiles, plan->settled, sizeof(state->tiles));
+    state->tiles_hash = plan->settled_hash;
 
-            auto completed_groups = false;
-            if(to_count >= 3) {
-                state->points += to_count;
+    refill_tiles(state->tiles, &state->refill, &state->tiles_hash);
 
-                delete_neighbours(state, time, drag_target_tile_x, drag_target_tile_y, from_tile_type);
+    for(auto x = 0; x < playfield_size; x += 1) {
+        auto space_count = 0;
+        while(space_count < playfield_size && plan->settled[space_count][x] == 0) {
+            space_count += 1;
+        }
 
-                completed_groups = true;
-            }
+        for(auto y = 0; y < space_count; y += 1) {
+            GameEvent spawn_event { GameEventKind::TileSpawned, time };
+            spawn_event.tile = { (int8_t)x, (int8_t)(y - space_count), (int8_t)y, state->tiles[y][x] };
+            emit_event(&state->events, spawn_event);
+        }
+    }
+}
 
-            auto from_count = count_neighbours(*state, counted, state->drag_start_tile_x, state->drag_start_tile_y, to_tile_type);
+// The swap was asked for at time, and its events start at start_time, once the board is ready
+// to show them
+static void commit_swap(GameState *state, double time, double start_time, const GameState::SwapPlan *plan) {
+    cancel_hint(state);
 
-            if(from_count >= 3) {
-                state->points += from_count;
+    add_latency_mark(state, LatencyMarkKind::Swap, time);
 
-                delete_neighbours(state, time, state->drag_start_tile_x, state->drag_start_tile_y, to_tile_type);
+    const auto undo_limit = 64;
 
-                completed_groups = true;
-            }
+    if(state->undo_snapshots.count == undo_limit) {
+        remove_at(&state->undo_snapshots, 0);
+    }
 
-            if(completed_groups) {
-                state->falling = true;
-                state->falling_tiles.count = 0;
-                state->falling_velocity = 0;
-                state->falling_amount = 0;
+    BoardSnapshot snapshot;
+    take_snapshot(&snapshot, state->tiles, state->tiles_hash, state->random, state->points);
 
-                state->last_displayed_points_tick = time;
+    append(&state->undo_snapshots, snapshot);
 
-                for(auto x = 0; x < playfield_size; x += 1) {
-                    auto space_count = 0;
+    auto from_x = plan->from_x;
+    auto from_y = plan->from_y;
+    auto to_x = plan->to_x;
+    auto to_y = plan->to_y;
 
-                    for(auto offset_y = 0; offset_y <= playfield_size - 1; offset_y += 1) {
-                        auto y = playfield_size - 1 - offset_y;
+    auto from_tile_type = state->tiles[from_y][from_x];
+    auto to_tile_type = state->tiles[to_y][to_x];
 
-                        auto kind = state->tiles[y][x];
+    state->tiles[from_y][from_x] = to_tile_type;
+    state->tiles[to_y][to_x] = from_tile_type;
 
-                        if(kind == 0) {
-                            space_count += 1;
-                        } else if(space_count > 0) {
-                            append(&state->falling_tiles, { x, y, y + space_count, kind });
+    state->tiles_hash ^= zobrist_key(from_x, from_y, from_tile_type) ^ zobrist_key(to_x, to_y, to_tile_type);
+    state->tiles_hash ^= zobrist_key(from_x, from_y, to_tile_type) ^ zobrist_key(to_x, to_y, from_tile_type);
 
-                            state->tiles[y][x] = 0;
-                        }
-                    }
+    GameEvent swap_event { GameEventKind::SwapAccepted, start_time };
+    swap_event.swap = { (int8_t)from_x, (int8_t)from_y, (int8_t)to_x, (int8_t)to_y, (int16_t)plan->points };
+    emit_event(&state->events, swap_event);
 
-                    for(auto i = 0; i < space_count; i += 1) {
-                        append(&state->falling_tiles, { x, 0 - space_count + i, i, GetRandomValue(1, tile_kind_count) });
-                    }
-                }
-            }
-        }
+    if(plan->points != 0) {
+        commit_clear(state, start_time, plan);
     }
+}
 
-    int drag_target_tile_x;
-    int drag_target_tile_y;
-    int drag_offset_screen_x;
-    int drag_offset_screen_y;
-    if(state->dragging) {
-        bool horizontal;
+// With the line rule settling can line up new runs, which clear as if a swap had cleared them.
+// Returns whether there were any.
+static bool cascade_tiles(GameState *state, double time) {
+    Tile tiles[playfield_size][playfield_size];
+    memcpy(tiles, state->tiles, sizeof(tiles));
 
-        if(abs(drag_difference_x) > abs(drag_difference_y)) {
-            int target_x;
-            if(drag_difference_x > 0) {
-                target_x = state->drag_start_tile_x + 1;
+    auto plan = &state->cascade_plan;
 
-            } else {
-                target_x = state->drag_start_tile_x - 1;
-            }
-            auto target_y = state->drag_start_tile_y;
+    auto hash = state->tiles_hash;
 
-            if(in_playfield(target_x, target_y)) {
-                horizontal = true;
-            } else {
-                horizontal = false;
-            }
-        } else {
-            auto target_x = state->drag_start_tile_x;
-            int target_y;
-            if(drag_difference_y > 0) {
-                target_y = state->drag_start_tile_y + 1;
-            } else {
-                target_y = state->drag_start_tile_y - 1;
-            }
+    plan->points = clear_rule_settled(state->rule, tiles, &hash);
 
-            if(in_playfield(target_x, target_y)) {
-                horizontal = false;
-            } else {
-                horizontal = true;
-            }
-        }
+    if(plan->points == 0) {
+        return false;
+    }
 
-        if(horizontal) {
-            if(drag_difference_x > 0) {
-                drag_target_tile_x = state->drag_start_tile_x + 1;
+    plan_settling(plan, state->tiles, tiles, hash);
 
-            } else {
-                drag_target_tile_x = state->drag_start_tile_x - 1;
-            }
-            drag_target_tile_y = state->drag_start_tile_y;
+    commit_clear(state, time, plan);
 
-            drag_offset_screen_x = max(min(drag_difference_x, tile_size), -tile_size);
-            drag_offset_screen_y = 0;
-        } else {
-            drag_target_tile_x = state->drag_start_tile_x;
-            if(drag_difference_y > 0) {
-                drag_target_tile_y = state->drag_start_tile_y + 1;
-            } else {
-                drag_target_tile_y = state->drag_start_tile_y - 1;
-            }
+    return true;
+}
 
-            drag_offset_screen_x = 0;
-            drag_offset_screen_y = max(min(drag_difference_y, tile_size), -tile_size);
-        }
-    }
+// Turns what happened into animations: cleared groups shrink away and burst into particles, and
+// then fallen and spawned tiles fall into place
+static void play_game_events(GameState *state) {
+    // Tiles fall once the cleared tiles have shrunk away
+    const auto clear_time = 0.08;
 
-    BeginDrawing();
+    GameEvent event;
 
+    while(next_event(&state->events, &state->visuals_cursor, &event)) {
+        switch(event.kind) {
+            case GameEventKind::SwapAccepted: break;
+
+            case GameEventKind::GroupCleared: {
+                auto total_x = 0;
+                auto total_y = 0;
+
+                for(auto cell = 0; cell < playfield_size * playfield_size; cell += 1) {
+                    if(((event.group.cells[cell / 64] >> (cell % 64)) & 1) == 0) {
+                        continue;
+                    }
+
+                    auto x = cell % playfield_size;
+                    auto y = cell / playfield_size;
+
+                    add_clearing_tile(state, event.time, clear_time, x, y, event.group.kind);
+                    add_tile_particles(state, event.time + clear_time, x, y, event.group.kind);
+
+                    total_x += x;
+                    total_y += y;
+                }
+
+                auto middle_x = (float)total_x / event.group.size + 0.5f;
+                auto middle_y = (float)total_y / event.group.size + 0.5f;
+
+                add_points_popup(state, event.time, middle_x, middle_y, event.group.size);
+            } break;
+
+            case GameEventKind::TileFell:
+            case GameEventKind::TileSpawned: {
+                add_falling_tile(state, event.time + clear_time, { event.tile.x, event.tile.from_y, event.tile.to_y, event.tile.kind });
+            } break;
+
+            case GameEventKind::ScoreChanged: {
+                start_points_ticker(state, event.time);
+            } break;
+        }
+    }
+}
+
+// With --stats the game keeps count of what happened, from the same events, and reports it on exit
+struct GameStats {
+    bool enabled;
+
+    uint64_t cursor;
+
+    int swap_count;
+    int scoring_swap_count;
+    int group_count;
+    int largest_group;
+    int fallen_tile_count;
+    int spawned_tile_count;
+};
+
+GameStats game_stats {};
+
+static void count_game_events(GameStats *stats, const GameEventRing *events) {
+    GameEvent event;
+
+    while(next_event(events, &stats->cursor, &event)) {
+        switch(event.kind) {
+            case GameEventKind::SwapAccepted: {
+                stats->swap_count += 1;
+                stats->scoring_swap_count += event.swap.points > 0 ? 1 : 0;
+            } break;
+
+            case GameEventKind::GroupCleared: {
+                stats->group_count += 1;
+                stats->largest_group = max(stats->largest_group, event.group.size);
+            } break;
+
+            case GameEventKind::TileFell: stats->fallen_tile_count += 1; break;
+            case GameEventKind::TileSpawned: stats->spawned_tile_count += 1; break;
+            case GameEventKind::ScoreChanged: break;
+        }
+    }
+}
+
+static void report_game_stats(const GameStats *stats) {
+    printf("%d swaps, %d of them scoring\n", stats->swap_count, stats->scoring_swap_count);
+    printf("    %d groups cleared, largest %d\n", stats->group_count, stats->largest_group);
+    printf("    %d tiles fell, %d spawned\n", stats->fallen_tile_count, stats->spawned_tile_count);
+}
+
+// The solver and the demo's search play the group rule, so with the line rule hints and the
+// demo take the swap that scores the most right away
+static int best_immediate_swap(GameState *state) {
+    auto best_swap = -1;
+    auto best_points = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        memcpy(tiles, state->tiles, sizeof(tiles));
+
+        auto points = simulate_rule_swap(state->rule, tiles, nullptr, i);
+
+        if(points > best_points) {
+            best_swap = i;
+            best_points = points;
+        }
+    }
+
+    return best_swap;
+}
+
+// Makes the swap on the board straight away, along with any cascade it sets off, while its
+// animations are put off until whatever is still settling has landed
+static void swap_tiles(GameState *state, double time, const GameState::SwapPlan *plan) {
+    commit_swap(state, time, settled_time(state, time), plan);
+
+    play_game_events(state);
+
+    while(cascade_tiles(state, settled_time(state, time))) {
+        play_game_events(state);
+    }
+}
+
+// Handles input in the order it happened, each event with the mouse where it was at the time
+static void handle_input_event(GameState *state, const InputEvent *event) {
+    auto mouse_x = event->mouse_x;
+    auto mouse_y = event->mouse_y;
+
+    state->mouse_x = mouse_x;
+    state->mouse_y = mouse_y;
+
+    switch(event->kind) {
+        case InputEventKind::MousePressed: {
+            int mouse_tile_x;
+            int mouse_tile_y;
+            screen_to_tile(mouse_x, mouse_y, &mouse_tile_x, &mouse_tile_y);
+
+            // Dragging works during falls as well, and the swap is made on the board they are
+            // landing in
+            if(!state->dragging && in_playfield(mouse_tile_x, mouse_tile_y)) {
+                state->dragging = true;
+                state->drag_start_mouse_x = mouse_x;
+                state->drag_start_mouse_y = mouse_y;
+                state->drag_start_tile_x = mouse_tile_x;
+                state->drag_start_tile_y = mouse_tile_y;
+
+                add_latency_mark(state, LatencyMarkKind::DragStart, event->time);
+            }
+        } break;
+
+        case InputEventKind::MouseReleased: {
+            if(!state->dragging) {
+                break;
+            }
+
+            state->dragging = false;
+
+            add_latency_mark(state, LatencyMarkKind::Release, event->time);
+
+            auto drag_difference_x = mouse_x - state->drag_start_mouse_x;
+            auto drag_difference_y = mouse_y - state->drag_start_mouse_y;
+
+            const auto fuzzy_delta = tile_size / 4;
+
+            auto swapping = false;
+            int drag_target_tile_x;
+            int drag_target_tile_y;
+            if(abs(drag_difference_x) > abs(drag_difference_y)) {
+                if(abs(drag_difference_x) >= tile_size - fuzzy_delta) {
+                    swapping = true;
+
+                    if(drag_difference_x > 0) {
+                        drag_target_tile_x = state->drag_start_tile_x + 1;
+                    } else {
+                        drag_target_tile_x = state->drag_start_tile_x - 1;
+                    }
+                    drag_target_tile_y = state->drag_start_tile_y;
+                }
+            } else {
+                if(abs(drag_difference_y) >= tile_size - fuzzy_delta) {
+                    swapping = true;
+
+                    drag_target_tile_x = state->drag_start_tile_x;
+                    if(drag_difference_y > 0) {
+                        drag_target_tile_y = state->drag_start_tile_y + 1;
+                    } else {
+                        drag_target_tile_y = state->drag_start_tile_y - 1;
+                    }
+                }
+            }
+
+            if(swapping && in_playfield(drag_target_tile_x, drag_target_tile_y)) {
+                auto plan = speculate_swap(state, state->drag_start_tile_x, state->drag_start_tile_y, drag_target_tile_x, drag_target_tile_y);
+
+                // Mid fall only swaps that score are made, so a swap aimed at tiles that have
+                // since moved is not made by accident
+                if(!board_settling(state) || plan->points > 0) {
+                    swap_tiles(state, event->time, plan);
+
+                    state->demo_last_swap = -1;
+                }
+            }
+        } break;
+
+        case InputEventKind::MouseMoved: break;
+
+        case InputEventKind::ToggleDemo: {
+            state->demo = !state->demo;
+            state->demo_last_swap = -1;
+        } break;
+
+        case InputEventKind::Undo: {
+            if(state->dragging || board_settling(state) || state->undo_snapshots.count == 0) {
+                break;
+            }
+
+            cancel_hint(state);
+
+            state->undo_snapshots.count -= 1;
+
+            auto snapshot = &state->undo_snapshots[state->undo_snapshots.count];
+
+            GameEvent score_event { GameEventKind::ScoreChanged, event->time };
+            score_event.score = { 0 - state->points, 0 };
+
+            restore_snapshot(snapshot, state->tiles, &state->tiles_hash, &state->random, &state->points);
+
+            score_event.score.change += state->points;
+            score_event.score.total = state->points;
+            emit_event(&state->events, score_event);
+
+            state->demo_last_swap = -1;
+        } break;
+
+        case InputEventKind::ToggleGlow: {
+            state->glow = !state->glow;
+        } break;
+
+        case InputEventKind::Hint: {
+            if(board_settling(state)) {
+                break;
+            }
+
+            cancel_hint(state);
+
+            if(state->rule == MatchRule::Lines) {
+                state->hint_swap = best_immediate_swap(state);
+
+                break;
+            }
+
+#if defined(PLATFORM_WEB)
+            // Without threads the search runs right away, shallow enough to fit in a frame
+            SolverResult result;
+            solve_best_points(state->tiles, nullptr, 2, 1, nullptr, &result);
+
+            state->hint_swap = result.swap_index;
+#else
+            const auto hint_depth = 3;
+
+            if(!state->hint_worker_ready) {
+                hint_start(&state->hint_worker, hint_depth);
+
+                state->hint_worker_ready = true;
+            }
+
+            hint_request(&state->hint_worker, state->tiles);
+
+            state->hint_pending = true;
+#endif
+        } break;
+    }
+}
+
+static void update_game(GameState *state, const InputEvent events[], int event_count, double time) {
+    auto tweens = &state->tweens;
+
+    tweens_advance(tweens, time);
+
+    if(state->points_tween != -1) {
+        auto counted = (int)(tween_value(tweens, state->points_tween) - state->points_tween_from);
+
+        state->displayed_points = state->points_tween_from + counted;
+
+        if(tween_done(tweens, state->points_tween)) {
+            tween_release(tweens, state->points_tween);
+
+            state->displayed_points = state->points;
+            state->points_tween = -1;
+        }
+    }
+
+    expire_visuals(&state->visuals, tweens);
+    place_visuals(&state->visuals, tweens);
+
+    for(auto i = 0; i < event_count; i += 1) {
+        handle_input_event(state, &events[i]);
+
+        play_game_events(state);
+    }
+
+    if(!board_settling(state) && state->potential_groups_hash != state->tiles_hash) {
+        int scoring_swaps[swap_count];
+        auto scoring_count = find_rule_scoring_swaps(state->rule, state->tiles, scoring_swaps);
+
+        mark_rule_potential(state->rule, state->tiles, scoring_swaps, scoring_count, state->potential_groups);
+
+        state->potential_groups_hash = state->tiles_hash;
+    }
+
+    if(state->hint_pending && hint_ready(&state->hint_worker, &state->hint_swap)) {
+        state->hint_pending = false;
+    }
+
+    if(state->demo && !state->dragging && !board_settling(state)) {
+        const auto demo_search_time = 0.005;
+
+        int swap_index;
+
+        if(state->rule == MatchRule::Lines) {
+            swap_index = best_immediate_swap(state);
+        } else {
+            if(!state->demo_player_ready) {
+#if defined(PLATFORM_WEB)
+                auto thread_count = 1;
+#else
+                auto thread_count = max((int)std::thread::hardware_concurrency(), 1);
+#endif
+
+                mcts_init(&state->demo_player, PlayoutPolicy::Random, thread_count, (uint32_t)GetRandomValue(0, 0x7FFFFFFF));
+
+                state->demo_player_ready = true;
+            }
+
+            if(state->demo_last_swap == -1) {
+                mcts_set_root(&state->demo_player, state->tiles);
+            } else {
+                mcts_advance(&state->demo_player, state->demo_last_swap, state->tiles);
+            }
+
+            swap_index = mcts_search(&state->demo_player, demo_search_time);
+        }
+
+        if(swap_index != -1) {
+            int from_x;
+            int from_y;
+            int to_x;
+            int to_y;
+            swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+            swap_tiles(state, time, speculate_swap(state, from_x, from_y, to_x, to_y));
+        }
+
+        state->demo_last_swap = swap_index;
+    }
+
+    if(game_stats.enabled) {
+        count_game_events(&game_stats, &state->events);
+    }
+
+    int drag_difference_x;
+    int drag_difference_y;
+    if(state->dragging) {
+        drag_difference_x = state->mouse_x - state->drag_start_mouse_x;
+        drag_difference_y = state->mouse_y - state->drag_start_mouse_y;
+    }
+
+    state->drag_plan = nullptr;
+    if(state->dragging) {
+        bool horizontal;
+
+        if(abs(drag_difference_x) > abs(drag_difference_y)) {
+            int target_x;
+            if(drag_difference_x > 0) {
+                target_x = state->drag_start_tile_x + 1;
+
+            } else {
+                target_x = state->drag_start_tile_x - 1;
+            }
+            auto target_y = state->drag_start_tile_y;
+
+            if(in_playfield(target_x, target_y)) {
+                horizontal = true;
+            } else {
+                horizontal = false;
+            }
+        } else {
+            auto target_x = state->drag_start_tile_x;
+            int target_y;
+            if(drag_difference_y > 0) {
+                target_y = state->drag_start_tile_y + 1;
+            } else {
+                target_y = state->drag_start_tile_y - 1;
+            }
+
+            if(in_playfield(target_x, target_y)) {
+                horizontal = false;
+            } else {
+                horizontal = true;
+            }
+        }
+
+        if(horizontal) {
+            if(drag_difference_x > 0) {
+                state->drag_target_tile_x = state->drag_start_tile_x + 1;
+
+            } else {
+                state->drag_target_tile_x = state->drag_start_tile_x - 1;
+            }
+            state->drag_target_tile_y = state->drag_start_tile_y;
+
+            state->drag_offset_screen_x = max(min(drag_difference_x, tile_size), -tile_size);
+            state->drag_offset_screen_y = 0;
+        } else {
+            state->drag_target_tile_x = state->drag_start_tile_x;
+            if(drag_difference_y > 0) {
+                state->drag_target_tile_y = state->drag_start_tile_y + 1;
+            } else {
+                state->drag_target_tile_y = state->drag_start_tile_y - 1;
+            }
+
+            state->drag_offset_screen_x = 0;
+            state->drag_offset_screen_y = max(min(drag_difference_y, tile_size), -tile_size);
+        }
+
+        // Swaps are made on the board as it settles, mid fall as well, and previewed on it too
+        if(in_playfield(state->drag_target_tile_x, state->drag_target_tile_y)) {
+            state->drag_plan = speculate_swap(state, state->drag_start_tile_x, state->drag_start_tile_y, state->drag_target_tile_x, state->drag_target_tile_y);
+        }
+    }
+}
+
+static void build_render_snapshot(GameState *state, RenderSnapshot *snapshot) {
+    memcpy(snapshot->tiles, state->tiles, sizeof(snapshot->tiles));
+
+    snapshot->dragging = state->dragging;
+    snapshot->drag_start_tile_x = state->drag_start_tile_x;
+    snapshot->drag_start_tile_y = state->drag_start_tile_y;
+    snapshot->drag_target_tile_x = state->drag_target_tile_x;
+    snapshot->drag_target_tile_y = state->drag_target_tile_y;
+    snapshot->drag_offset_screen_x = state->drag_offset_screen_x;
+    snapshot->drag_offset_screen_y = state->drag_offset_screen_y;
+
+    snapshot->drag_preview = state->drag_plan != nullptr;
+    if(snapshot->drag_preview) {
+        memcpy(snapshot->drag_cleared, state->drag_plan->cleared, sizeof(snapshot->drag_cleared));
+    }
+
+    snapshot->glow = state->glow && !board_settling(state);
+    if(snapshot->glow) {
+        memcpy(snapshot->potential_groups, state->potential_groups, sizeof(snapshot->potential_groups));
+    }
+
+    snapshot->hint_swap = state->hint_swap;
+
+    auto visuals = &state->visuals;
+
+    // The board already holds the tiles that are still falling into place
+    for(auto i = 0; i < visuals->settling.count; i += 1) {
+        auto cell = visuals->settling.values[i];
+
+        snapshot->tiles[cell.y][cell.x] = 0;
+    }
+
+    // Shapes are drawn in order, so particles and popups show over tiles. Past the limit the
+    // last are left out, which only happens in long demo cascades.
+    VisualShape shapes[] = { VisualShape::ShrinkingTile, VisualShape::FullTile, VisualShape::Particle, VisualShape::Popup };
+
+    snapshot->visual_count = 0;
+
+    for(auto shape : shapes) {
+        for(auto i = 0; i < visuals->appearances.count && snapshot->visual_count < max_drawn_visuals; i += 1) {
+            auto appearance = visuals->appearances.values[i];
+
+            if(appearance.shape != shape) {
+                continue;
+            }
+
+            auto placement = component_of(&visuals->placements, visuals->appearances.owners[i]);
+
+            if(placement->shown) {
+                snapshot->visuals[snapshot->visual_count] = { placement->x, placement->y, placement->scale, shape, appearance.kind, appearance.number };
+                snapshot->visual_count += 1;
+            }
+        }
+    }
+
+    snapshot->displayed_points = state->displayed_points;
+    snapshot->demo = state->demo;
+
+    auto drawn = latency_marks_drawn.load(std::memory_order_acquire);
+
+    auto kept_count = 0;
+
+    for(auto i = 0; i < state->latency_mark_count; i += 1) {
+        if(state->latency_marks[i].number >= drawn) {
+            state->latency_marks[kept_count] = state->latency_marks[i];
+            kept_count += 1;
+        }
+    }
+
+    state->latency_mark_count = kept_count;
+
+    snapshot->latency_mark_count = state->latency_mark_count;
+    memcpy(snapshot->latency_marks, state->latency_marks, state->latency_mark_count * sizeof(LatencyMark));
+}
+
+static void draw_game(const RenderSnapshot *snapshot) {
     ClearBackground(RAYWHITE);
 
     for(auto y = 0; y < playfield_size; y += 1) {
         for(auto x = 0; x < playfield_size; x += 1) {
-            auto tile_kind = state->tiles[y][x];
+            auto tile_kind = snapshot->tiles[y][x];
 
             if(tile_kind == 0) {
                 continue;
@@ -437,71 +1348,131 @@ static void gameplay_loop(GameState *state) {
             int screen_y;
             tile_to_screen(x, y, &screen_x, &screen_y);
 
-            if(state->dragging) {
-                if(x == state->drag_start_tile_x && y == state->drag_start_tile_y) {
+            if(snapshot->dragging) {
+                if(x == snapshot->drag_start_tile_x && y == snapshot->drag_start_tile_y) {
                     continue;
-                } else if(x == drag_target_tile_x && y == drag_target_tile_y) {
+                } else if(x == snapshot->drag_target_tile_x && y == snapshot->drag_target_tile_y) {
                     continue;
                 }
             }
 
             draw_tile_at(screen_x, screen_y, tile_kind);
+
+            if(snapshot->glow && snapshot->potential_groups[y][x]) {
+                DrawRectangle(screen_x + tile_inset * 2, screen_y + tile_inset * 2, tile_size - tile_inset * 4, tile_size - tile_inset * 4, Fade(WHITE, 0.4f));
+            }
         }
     }
 
-    if(state->dragging) {
-        if(in_playfield(drag_target_tile_x, drag_target_tile_y)) {
+    if(snapshot->drag_preview) {
+        for(auto y = 0; y < playfield_size; y += 1) {
+            for(auto x = 0; x < playfield_size; x += 1) {
+                if(snapshot->drag_cleared[y][x] == 0) {
+                    continue;
+                }
+
+                int screen_x;
+                int screen_y;
+                tile_to_screen(x, y, &screen_x, &screen_y);
+
+                DrawRectangleLines(screen_x, screen_y, tile_size, tile_size, GRAY);
+            }
+        }
+    }
+
+    if(snapshot->dragging) {
+        // During falls either dragged tile can be a gap
+        Tile target_kind = 0;
+        if(in_playfield(snapshot->drag_target_tile_x, snapshot->drag_target_tile_y)) {
+            target_kind = snapshot->tiles[snapshot->drag_target_tile_y][snapshot->drag_target_tile_x];
+        }
+
+        if(target_kind != 0) {
             int screen_x;
             int screen_y;
-            tile_to_screen(drag_target_tile_x, drag_target_tile_y, &screen_x, &screen_y);
+            tile_to_screen(snapshot->drag_target_tile_x, snapshot->drag_target_tile_y, &screen_x, &screen_y);
 
-            screen_x -= drag_offset_screen_x;
-            screen_y -= drag_offset_screen_y;
+            screen_x -= snapshot->drag_offset_screen_x;
+            screen_y -= snapshot->drag_offset_screen_y;
 
-            draw_tile_at(screen_x, screen_y, state->tiles[drag_target_tile_y][drag_target_tile_x]);
+            draw_tile_at(screen_x, screen_y, target_kind);
         }
 
         {
             int screen_x;
             int screen_y;
-            tile_to_screen(state->drag_start_tile_x, state->drag_start_tile_y, &screen_x, &screen_y);
+            tile_to_screen(snapshot->drag_start_tile_x, snapshot->drag_start_tile_y, &screen_x, &screen_y);
 
-            screen_x += drag_offset_screen_x;
-            screen_y += drag_offset_screen_y;
+            screen_x += snapshot->drag_offset_screen_x;
+            screen_y += snapshot->drag_offset_screen_y;
 
-            draw_tile_at(screen_x, screen_y, state->tiles[state->drag_start_tile_y][state->drag_start_tile_x]);
+            auto start_kind = snapshot->tiles[snapshot->drag_start_tile_y][snapshot->drag_start_tile_x];
+            if(start_kind != 0) {
+                draw_tile_at(screen_x, screen_y, start_kind);
+            }
 
             DrawRectangleLinesEx({ (float)screen_x, (float)screen_y, tile_size, tile_size }, tile_inset, DARKGRAY);
         }
     }
 
-    if(state->falling) {
-        for(auto tile : state->falling_tiles) {
+    if(snapshot->hint_swap != -1) {
+        int hint_tiles[2][2];
+        swap_from_index(snapshot->hint_swap, &hint_tiles[0][0], &hint_tiles[0][1], &hint_tiles[1][0], &hint_tiles[1][1]);
+
+        for(auto i = 0; i < 2; i += 1) {
             int screen_x;
             int screen_y;
-            tile_to_screen(tile.x, tile.start_y, &screen_x, &screen_y);
-
-            screen_y = (int)(screen_y + state->falling_amount * tile_size);
+            tile_to_screen(hint_tiles[i][0], hint_tiles[i][1], &screen_x, &screen_y);
 
-            draw_tile_at(screen_x, screen_y, tile.kind);
+            DrawRectangleLinesEx({ (float)screen_x, (float)screen_y, tile_size, tile_size }, tile_inset, BLACK);
         }
     }
 
-    for(auto particle : state->particles) {
-        int playfield_x;
-        int playfield_y;
-        playfield_position(&playfield_x, &playfield_y);
+    int playfield_x;
+    int playfield_y;
+    playfield_position(&playfield_x, &playfield_y);
+
+    for(auto i = 0; i < snapshot->visual_count; i += 1) {
+        auto visual = snapshot->visuals[i];
+
+        auto screen_x = playfield_x + visual.x * tile_size;
+        auto screen_y = playfield_y + visual.y * tile_size;
+
+        switch(visual.shape) {
+            case VisualShape::ShrinkingTile: {
+                auto size = (tile_size - tile_inset * 2) * visual.scale;
 
-        auto x = (int)(particle.x * tile_size + playfield_x);
-        auto y = (int)(particle.y * tile_size + playfield_y);
+                auto x = (int)(screen_x + tile_size * 0.5f - size / 2);
+                auto y = (int)(screen_y + tile_size * 0.5f - size / 2);
 
-        const auto size = tile_size / 3;
+                DrawRectangle(x, y, (int)size, (int)size, tile_color(visual.kind));
+            } break;
 
-        DrawRectangle(x, y, size, size, particle.color);
+            case VisualShape::FullTile: {
+                draw_tile_at((int)screen_x, (int)screen_y, visual.kind);
+            } break;
+
+            case VisualShape::Particle: {
+                const auto size = tile_size / 3;
+
+                DrawRectangle((int)screen_x, (int)screen_y, size, size, tile_color(visual.kind));
+            } break;
+
+            case VisualShape::Popup: {
+                const auto popup_font_size = 20;
+
+                char text[16];
+                snprintf(text, 16, "+%d", visual.number);
+
+                auto popup_width = MeasureText(text, popup_font_size);
+
+                DrawText(text, (int)screen_x - popup_width / 2, (int)screen_y - popup_font_size / 2, popup_font_size, DARKGRAY);
+            } break;
+        }
     }
 
     char buffer[128];
-    snprintf(buffer, 128, "%d", state->displayed_points);
+    snprintf(buffer, 128, "%d", snapshot->displayed_points);
 
     const auto font_size = 40;
 
@@ -509,20 +1480,352 @@ static void gameplay_loop(GameState *state) {
 
     DrawText(buffer, window_width / 2 - text_width / 2, 100, font_size, DARKGRAY);
 
+    if(snapshot->demo) {
+        const auto demo_font_size = 20;
+
+        auto demo_text_width = MeasureText("DEMO", demo_font_size);
+
+        DrawText("DEMO", window_width / 2 - demo_text_width / 2, 100 + font_size, demo_font_size, GRAY);
+    }
+}
+
+// With --latency every mark is timed to the frame that first shows it, both to when the frame is
+// handed to EndDrawing and to when EndDrawing returns, having swapped buffers and waited out the
+// frame rate cap. The buffer swap, and so the photons, fall somewhere in between.
+struct LatencySample {
+    LatencyMarkKind kind;
+
+    double event_time;
+    double submit_time;
+    double frame_end_time;
+};
+
+struct LatencyRecording {
+    bool enabled;
+    const char *path;
+
+    List<LatencySample> samples;
+};
+
+LatencyRecording latency_recording {};
+
+static int compare_doubles(const void *a, const void *b) {
+    auto difference = *(const double*)a - *(const double*)b;
+
+    return (difference > 0) - (difference < 0);
+}
+
+// In milliseconds, from latencies sorted in seconds
+static double latency_percentile(const double *latencies, int count, double fraction) {
+    return latencies[min((int)(fraction * count), count - 1)] * 1000;
+}
+
+static void report_latency_percentiles(const char *name, double *latencies, int count) {
+    qsort(latencies, count, sizeof(double), compare_doubles);
+
+    printf(
+        "    %-10s min %6.2f  p50 %6.2f  p90 %6.2f  p99 %6.2f  max %6.2f ms\n",
+        name,
+        latency_percentile(latencies, count, 0),
+        latency_percentile(latencies, count, 0.5),
+        latency_percentile(latencies, count, 0.9),
+        latency_percentile(latencies, count, 0.99),
+        latency_percentile(latencies, count, 1)
+    );
+}
+
+static void report_latency(LatencyRecording *recording) {
+    auto sample_count = max((int)recording->samples.count, 1);
+
+    auto submit_latencies = (double*)malloc(sample_count * sizeof(double));
+    auto frame_end_latencies = (double*)malloc(sample_count * sizeof(double));
+
+    for(auto kind = 0; kind <= (int)LatencyMarkKind::Swap; kind += 1) {
+        auto count = 0;
+
+        for(auto sample : recording->samples) {
+            if((int)sample.kind == kind) {
+                submit_latencies[count] = sample.submit_time - sample.event_time;
+                frame_end_latencies[count] = sample.frame_end_time - sample.event_time;
+
+                count += 1;
+            }
+        }
+
+        printf("%s, %d samples\n", latency_mark_names[kind], count);
+
+        if(count != 0) {
+            report_latency_percentiles("submit", submit_latencies, count);
+            report_latency_percentiles("frame end", frame_end_latencies, count);
+        }
+    }
+
+    free(frame_end_latencies);
+    free(submit_latencies);
+
+    if(recording->path == nullptr) {
+        return;
+    }
+
+    auto file = fopen(recording->path, "w");
+
+    if(file == nullptr) {
+        printf("could not open %s\n", recording->path);
+
+        return;
+    }
+
+    fprintf(file, "kind,event_time,submit_time,frame_end_time\n");
+
+    for(auto sample : recording->samples) {
+        fprintf(file, "%s,%.6f,%.6f,%.6f\n", latency_mark_names[(int)sample.kind], sample.event_time, sample.submit_time, sample.frame_end_time);
+    }
+
+    fclose(file);
+}
+
+// With --fps or --vsync the end of every frame is timed, to report how evenly frames are paced
+struct FramePacing {
+    bool enabled;
+
+    // Frames per second asked for, or 0 for uncapped
+    int target_fps;
+
+    List<double> frame_end_times;
+};
+
+FramePacing frame_pacing {};
+
+static void report_frame_pacing(FramePacing *pacing) {
+    auto interval_count = (int)pacing->frame_end_times.count - 1;
+
+    if(interval_count < 1) {
+        return;
+    }
+
+    auto intervals = (double*)malloc(interval_count * sizeof(double));
+
+    auto total = 0.0;
+
+    for(auto i = 0; i < interval_count; i += 1) {
+        intervals[i] = pacing->frame_end_times[i + 1] - pacing->frame_end_times[i];
+
+        total += intervals[i];
+    }
+
+    auto mean = total / interval_count;
+
+    auto variance = 0.0;
+
+    for(auto i = 0; i < interval_count; i += 1) {
+        variance += (intervals[i] - mean) * (intervals[i] - mean);
+    }
+
+    variance /= interval_count;
+
+    // Frames that took half again as long as they should have, which shows as a stutter
+    auto expected = pacing->target_fps > 0 ? 1.0 / pacing->target_fps : mean;
+
+    auto late_count = 0;
+
+    for(auto i = 0; i < interval_count; i += 1) {
+        if(intervals[i] > expected * 1.5) {
+            late_count += 1;
+        }
+    }
+
+    printf("%d frames, %.1f fps on average (target %d)\n", interval_count, 1 / mean, pacing->target_fps);
+    printf("    frame time mean %.2f ms, standard deviation %.2f ms, %d late frames\n", mean * 1000, sqrt(variance) * 1000, late_count);
+
+    report_latency_percentiles("frame time", intervals, interval_count);
+
+    free(intervals);
+}
+
+static void present_snapshot(const RenderSnapshot *snapshot) {
+    BeginDrawing();
+
+    draw_game(snapshot);
+
+    auto submit_time = GetTime();
+
     EndDrawing();
+
+    auto frame_end_time = GetTime();
+
+    if(frame_pacing.enabled) {
+        append(&frame_pacing.frame_end_times, frame_end_time);
+    }
+
+    if(snapshot->latency_mark_count == 0) {
+        return;
+    }
+
+    // Marks are carried until drawing hands back that it has shown them, so a snapshot can hold
+    // some that an earlier frame already did
+    auto drawn = latency_marks_drawn.load(std::memory_order_relaxed);
+
+    if(latency_recording.enabled) {
+        for(auto i = 0; i < snapshot->latency_mark_count; i += 1) {
+            auto mark = snapshot->latency_marks[i];
+
+            if(mark.number >= drawn) {
+                append(&latency_recording.samples, { mark.kind, mark.event_time, submit_time, frame_end_time });
+            }
+        }
+    }
+
+    auto last_number = snapshot->latency_marks[snapshot->latency_mark_count - 1].number;
+
+    if(last_number >= drawn) {
+        latency_marks_drawn.store(last_number + 1, std::memory_order_release);
+    }
+}
+
+static void gameplay_loop(GameState *state, RenderSnapshot *snapshot) {
+    poll_input();
+
+    InputEvent events[input_queue_capacity];
+    auto event_count = take_input_events(events);
+
+    update_game(state, events, event_count, GetTime());
+
+    build_render_snapshot(state, snapshot);
+    present_snapshot(snapshot);
 }
 
 #if defined(PLATFORM_WEB)
 GameState web_state {};
+RenderSnapshot web_snapshot;
 
 static void web_gameplay_loop() {
-    gameplay_loop(&web_state);
+    gameplay_loop(&web_state, &web_snapshot);
+}
+#else
+// In threaded mode the simulation updates at a fixed rate on a thread of its own and publishes a
+// snapshot after every update, while the main thread only gathers input and draws the newest
+// snapshot. A slow frame then holds up neither the game nor the searches it runs.
+const auto simulation_rate = 120;
+
+struct SimulationThread {
+    GameState *state;
+
+    TripleBuffer<RenderSnapshot> snapshots;
+
+    std::atomic<bool> running;
+};
+
+SimulationThread simulation_thread;
+
+static void run_simulation(SimulationThread *simulation) {
+    const auto update_time = 1.0 / simulation_rate;
+    const auto update_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(update_time));
+
+    // Longest the simulation catches up by after falling behind, such as during a long search
+    const auto max_lag = std::chrono::milliseconds(100);
+
+    auto next_update = std::chrono::steady_clock::now();
+
+    while(simulation->running.load(std::memory_order_relaxed)) {
+        InputEvent events[input_queue_capacity];
+        auto event_count = take_input_events(events);
+
+        // Updates use the same clock as input events, which animations are timed from
+        update_game(simulation->state, events, event_count, GetTime());
+
+        build_render_snapshot(simulation->state, triple_buffer_back(&simulation->snapshots));
+        triple_buffer_publish(&simulation->snapshots);
+
+        next_update += update_duration;
+
+        auto now = std::chrono::steady_clock::now();
+        if(next_update < now - max_lag) {
+            next_update = now;
+        }
+
+        std::this_thread::sleep_until(next_update);
+    }
+}
+
+static void threaded_gameplay(GameState *state) {
+    auto simulation = &simulation_thread;
+
+    simulation->state = state;
+    simulation->running = true;
+
+    triple_buffer_init(&simulation->snapshots);
+
+    // The first snapshot is published before the thread starts, so there is always one to draw
+    build_render_snapshot(state, triple_buffer_back(&simulation->snapshots));
+    triple_buffer_publish(&simulation->snapshots);
+
+    std::thread thread(run_simulation, simulation);
+
+    while(!WindowShouldClose()) {
+        poll_input();
+
+        present_snapshot(triple_buffer_front(&simulation->snapshots));
+    }
+
+    simulation->running = false;
+    thread.join();
 }
 #endif
 
 int main(int argument_count, const char *arguments[]) {
+    // With --lines swaps clear straight runs, as in the classic game, rather than groups
+    auto rule = MatchRule::Groups;
+
+#if !defined(PLATFORM_WEB)
+    auto threaded = false;
+    auto vsync = false;
+    auto fps_given = false;
+
+    frame_pacing.target_fps = 60;
+
+    for(auto i = 1; i < argument_count; i += 1) {
+        if(strcmp(arguments[i], "--lines") == 0) {
+            rule = MatchRule::Lines;
+        } else if(strcmp(arguments[i], "--threaded") == 0) {
+            threaded = true;
+        } else if(strcmp(arguments[i], "--fps") == 0 && i + 1 < argument_count) {
+            // Such as 120, 144 or 240, or 0 for as fast as frames can be drawn
+            frame_pacing.target_fps = max(atoi(arguments[i + 1]), 0);
+            frame_pacing.enabled = true;
+            fps_given = true;
+
+            i += 1;
+        } else if(strcmp(arguments[i], "--vsync") == 0) {
+            vsync = true;
+            frame_pacing.enabled = true;
+        } else if(strcmp(arguments[i], "--stats") == 0) {
+            game_stats.enabled = true;
+        } else if(strcmp(arguments[i], "--latency") == 0) {
+            latency_recording.enabled = true;
+
+            if(i + 1 < argument_count && arguments[i + 1][0] != '-') {
+                latency_recording.path = arguments[i + 1];
+
+                i += 1;
+            }
+        }
+    }
+
+    if(vsync) {
+        SetConfigFlags(FLAG_VSYNC_HINT);
+
+        // Unless a cap is asked for as well, the swap interval paces frames at the monitor's
+        // refresh rate, whatever it is, and late frames are judged against the mean interval
+        if(!fps_given) {
+            frame_pacing.target_fps = 0;
+        }
+    }
+#endif
+
     InitWindow(window_width, window_height, "Match Three");
 
+    spsc_init(&input_queue);
+
 #if defined(PLATFORM_WEB)
     auto state = &web_state;
 #else
@@ -531,25 +1834,62 @@ int main(int argument_count, const char *arguments[]) {
     auto state = &the_state;
 #endif
 
-    for(auto y = 0; y < playfield_size; y += 1) {
-        for(auto x = 0; x < playfield_size; x += 1) {
-            state->tiles[y][x] = GetRandomValue(1, tile_kind_count);
-        }
-    }
+    state->rule = rule;
+
+    const auto opening_move_count = 3;
+
+    seed_random(&state->random, (uint32_t)GetRandomValue(0, 0x7FFFFFFF));
+    state->refill = { &state->random };
+
+    generate_tiles(state->tiles, &state->random, opening_move_count);
 
-    state->last_displayed_points_tick = GetTime();
+    state->tiles_hash = hash_tiles(state->tiles);
+
+    tweens_init(&state->tweens, 8192, GetTime());
+    visuals_init(&state->visuals, 4096);
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(web_gameplay_loop, 0, 1);
 #else
-    SetTargetFPS(60);
+    hook_mouse_input();
 
-    while(!WindowShouldClose()) {
-        gameplay_loop(state);
+    SetTargetFPS(frame_pacing.target_fps);
+
+    if(threaded) {
+        threaded_gameplay(state);
+    } else {
+        RenderSnapshot snapshot;
+
+        while(!WindowShouldClose()) {
+            gameplay_loop(state, &snapshot);
+        }
     }
 #endif
 
+    if(state->demo_player_ready) {
+        mcts_free(&state->demo_player);
+    }
+
+    if(state->hint_worker_ready) {
+        hint_stop(&state->hint_worker);
+    }
+
+    visuals_free(&state->visuals);
+    tweens_free(&state->tweens);
+
+    if(latency_recording.enabled) {
+        report_latency(&latency_recording);
+    }
+
+    if(frame_pacing.enabled) {
+        report_frame_pacing(&frame_pacing);
+    }
+
+    if(game_stats.enabled) {
+        report_game_stats(&game_stats);
+    }
+
     CloseWindow();
 
     return 0;
-}
\ No newline at end of file
+}
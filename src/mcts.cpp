@@ -0,0 +1,336 @@
+#include "mcts.h"
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+static double get_seconds() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    return std::chrono::duration<double>(now).count();
+}
+
+// Scaled to the points of a typical group, since node values are points rather than win rates
+const auto exploration = 4.0;
+
+const auto random_swap_attempts = 32;
+
+const auto tree_node_limit = 1 << 20;
+
+static int add_node(MctsTree *tree, int swap_index) {
+    return (int)append(&tree->nodes, { swap_index, 0, 0, -1, -1 });
+}
+
+static void reset_tree(MctsTree *tree) {
+    tree->nodes.count = 0;
+    tree->root = add_node(tree, -1);
+}
+
+void mcts_init(MctsPlayer *player, PlayoutPolicy policy, int thread_count, uint32_t seed) {
+    player->policy = policy;
+    player->thread_count = thread_count;
+    player->trees = (MctsTree*)malloc(thread_count * sizeof(MctsTree));
+
+    for(auto i = 0; i < thread_count; i += 1) {
+        auto tree = &player->trees[i];
+
+        tree->nodes = {};
+        seed_random(&tree->random, seed + (uint32_t)i);
+
+        reset_tree(tree);
+    }
+
+    memset(player->root_tiles, 0, sizeof(player->root_tiles));
+}
+
+void mcts_free(MctsPlayer *player) {
+    for(auto i = 0; i < player->thread_count; i += 1) {
+        free(player->trees[i].nodes.elements);
+    }
+
+    free(player->trees);
+}
+
+void mcts_set_root(MctsPlayer *player, const Tile tiles[playfield_size][playfield_size]) {
+    memcpy(player->root_tiles, tiles, sizeof(player->root_tiles));
+
+    for(auto i = 0; i < player->thread_count; i += 1) {
+        reset_tree(&player->trees[i]);
+    }
+}
+
+static int copy_subtree(List<MctsNode> *from, List<MctsNode> *to, int node) {
+    auto copy = (*from)[node];
+    copy.first_child = -1;
+    copy.next_sibling = -1;
+
+    auto index = (int)append(to, copy);
+
+    for(auto child = (*from)[node].first_child; child != -1; child = (*from)[child].next_sibling) {
+        auto copied_child = copy_subtree(from, to, child);
+
+        (*to)[copied_child].next_sibling = (*to)[index].first_child;
+        (*to)[index].first_child = copied_child;
+    }
+
+    return index;
+}
+
+void mcts_advance(MctsPlayer *player, int swap_index, const Tile tiles[playfield_size][playfield_size]) {
+    memcpy(player->root_tiles, tiles, sizeof(player->root_tiles));
+
+    for(auto i = 0; i < player->thread_count; i += 1) {
+        auto tree = &player->trees[i];
+
+        auto new_root = -1;
+        for(auto child = tree->nodes[tree->root].first_child; child != -1; child = tree->nodes[child].next_sibling) {
+            if(tree->nodes[child].swap_index == swap_index) {
+                new_root = child;
+
+                break;
+            }
+        }
+
+        if(new_root == -1) {
+            reset_tree(tree);
+        } else {
+            List<MctsNode> nodes {};
+            tree->root = copy_subtree(&tree->nodes, &nodes, new_root);
+
+            free(tree->nodes.elements);
+            tree->nodes = nodes;
+        }
+    }
+}
+
+static int random_scoring_swap(Tile tiles[playfield_size][playfield_size], Random *random) {
+    for(auto i = 0; i < random_swap_attempts; i += 1) {
+        auto swap_index = (int)(next_random(random) % swap_count);
+
+        if(swap_scores(tiles, swap_index)) {
+            return swap_index;
+        }
+    }
+
+    return -1;
+}
+
+static int greedy_swap(Tile tiles[playfield_size][playfield_size]) {
+    auto best_swap = -1;
+    auto best_points = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        if(!swap_scores(tiles, i)) {
+            continue;
+        }
+
+        auto points = swap_points(tiles, i);
+
+        if(points > best_points) {
+            best_swap = i;
+            best_points = points;
+        }
+    }
+
+    return best_swap;
+}
+
+static void run_iteration(MctsTree *tree, const Tile root_tiles[playfield_size][playfield_size], PlayoutPolicy policy) {
+    Tile tiles[playfield_size][playfield_size];
+    memcpy(tiles, root_tiles, sizeof(tiles));
+
+    int path[mcts_search_depth + 1];
+    int points[mcts_search_depth];
+
+    path[0] = tree->root;
+
+    auto node = tree->root;
+    auto depth = 0;
+    auto expanded = false;
+
+    while(depth < mcts_search_depth && !expanded) {
+        int scoring_swaps[swap_count];
+        auto scoring_count = find_scoring_swaps(tiles, scoring_swaps);
+
+        if(scoring_count == 0) {
+            break;
+        }
+
+        bool scoring[swap_count] {};
+        for(auto i = 0; i < scoring_count; i += 1) {
+            scoring[scoring_swaps[i]] = true;
+        }
+
+        // Children are only considered when their swap still scores on the board this
+        // iteration drew, which differs from other iterations once refills come into play
+        bool tried[swap_count] {};
+        auto tried_count = 0;
+
+        auto best_child = -1;
+        auto best_value = 0.0;
+
+        auto log_visits = log((double)tree->nodes[node].visits + 1);
+
+        for(auto child = tree->nodes[node].first_child; child != -1; child = tree->nodes[child].next_sibling) {
+            auto child_node = tree->nodes[child];
+
+            if(!scoring[child_node.swap_index]) {
+                continue;
+            }
+
+            tried[child_node.swap_index] = true;
+            tried_count += 1;
+
+            auto value = child_node.total_points / child_node.visits + exploration * sqrt(log_visits / child_node.visits);
+
+            if(best_child == -1 || value > best_value) {
+                best_child = child;
+                best_value = value;
+            }
+        }
+
+        if(tried_count < scoring_count && tree->nodes.count < tree_node_limit) {
+            // Untried swaps are expanded best immediate points first, so even a search that
+            // only gets through a few iterations plays at least as well as a greedy player
+            auto swap_index = -1;
+            auto best_points = 0;
+
+            for(auto i = 0; i < scoring_count; i += 1) {
+                if(tried[scoring_swaps[i]]) {
+                    continue;
+                }
+
+                auto candidate_points = swap_points(tiles, scoring_swaps[i]);
+
+                if(candidate_points > best_points) {
+                    swap_index = scoring_swaps[i];
+                    best_points = candidate_points;
+                }
+            }
+
+            auto child = add_node(tree, swap_index);
+
+            tree->nodes[child].next_sibling = tree->nodes[node].first_child;
+            tree->nodes[node].first_child = child;
+
+            node = child;
+            expanded = true;
+        } else if(best_child != -1) {
+            node = best_child;
+        } else {
+            break;
+        }
+
+        points[depth] = simulate_swap(tiles, &tree->random, tree->nodes[node].swap_index);
+
+        depth += 1;
+        path[depth] = node;
+    }
+
+    auto path_length = depth + 1;
+
+    while(depth < mcts_search_depth) {
+        int swap_index;
+        if(policy == PlayoutPolicy::Greedy) {
+            swap_index = greedy_swap(tiles);
+        } else {
+            swap_index = random_scoring_swap(tiles, &tree->random);
+        }
+
+        if(swap_index == -1) {
+            break;
+        }
+
+        points[depth] = simulate_swap(tiles, &tree->random, swap_index);
+
+        depth += 1;
+    }
+
+    // Each node is credited with the points scored from its own swap onwards
+    auto total_points = 0.0;
+    for(auto i = depth - 1; i >= 0; i -= 1) {
+        total_points += points[i];
+
+        if(i + 1 < path_length) {
+            auto path_node = &tree->nodes[path[i + 1]];
+
+            path_node->visits += 1;
+            path_node->total_points += total_points;
+        }
+    }
+
+    tree->nodes[tree->root].visits += 1;
+    tree->nodes[tree->root].total_points += total_points;
+}
+
+static void search_tree(MctsTree *tree, const Tile root_tiles[playfield_size][playfield_size], PlayoutPolicy policy, double end_time) {
+    const auto iterations_per_time_check = 4;
+
+    do {
+        for(auto i = 0; i < iterations_per_time_check; i += 1) {
+            run_iteration(tree, root_tiles, policy);
+        }
+    } while(get_seconds() < end_time);
+}
+
+int mcts_search(MctsPlayer *player, double time_limit) {
+    int scoring_swaps[swap_count];
+    auto scoring_count = find_scoring_swaps(player->root_tiles, scoring_swaps);
+
+    if(scoring_count == 0) {
+        return -1;
+    }
+
+    auto end_time = get_seconds() + time_limit;
+
+    auto threads = new std::thread[player->thread_count - 1];
+
+    for(auto i = 1; i < player->thread_count; i += 1) {
+        threads[i - 1] = std::thread(search_tree, &player->trees[i], player->root_tiles, player->policy, end_time);
+    }
+
+    search_tree(&player->trees[0], player->root_tiles, player->policy, end_time);
+
+    for(auto i = 1; i < player->thread_count; i += 1) {
+        threads[i - 1].join();
+    }
+
+    delete[] threads;
+
+    int visits[swap_count] {};
+    double total_points[swap_count] {};
+
+    for(auto i = 0; i < player->thread_count; i += 1) {
+        auto tree = &player->trees[i];
+
+        for(auto child = tree->nodes[tree->root].first_child; child != -1; child = tree->nodes[child].next_sibling) {
+            visits[tree->nodes[child].swap_index] += tree->nodes[child].visits;
+            total_points[tree->nodes[child].swap_index] += tree->nodes[child].total_points;
+        }
+    }
+
+    // The most visited swap wins, with average points breaking ties between equally visited ones
+    auto best_swap = -1;
+    auto best_average = 0.0;
+
+    for(auto i = 0; i < scoring_count; i += 1) {
+        auto swap_index = scoring_swaps[i];
+
+        if(visits[swap_index] == 0) {
+            continue;
+        }
+
+        auto average = total_points[swap_index] / visits[swap_index];
+
+        if(best_swap == -1 || visits[swap_index] > visits[best_swap] || (visits[swap_index] == visits[best_swap] && average > best_average)) {
+            best_swap = swap_index;
+            best_average = average;
+        }
+    }
+
+    if(best_swap == -1) {
+        best_swap = greedy_swap(player->root_tiles);
+    }
+
+    return best_swap;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "list.h"
+#include "rules.h"
+
+enum struct PlayoutPolicy {
+    Random,
+    Greedy
+};
+
+struct MctsNode {
+    int swap_index;
+
+    int visits;
+    double total_points;
+
+    int first_child;
+    int next_sibling;
+};
+
+// Each thread searches a tree of its own, and the trees are only combined at the root when
+// picking a move, so playouts never wait on each other.
+struct MctsTree {
+    List<MctsNode> nodes;
+
+    int root;
+
+    Random random;
+};
+
+// Open-loop search: nodes stand for sequences of swaps rather than boards, and every iteration
+// replays its sequence from the root with freshly drawn refills, so the search never relies on
+// knowing which tiles will fall in.
+struct MctsPlayer {
+    PlayoutPolicy policy;
+
+    int thread_count;
+    MctsTree *trees;
+
+    Tile root_tiles[playfield_size][playfield_size];
+};
+
+const auto mcts_search_depth = 8;
+
+void mcts_init(MctsPlayer *player, PlayoutPolicy policy, int thread_count, uint32_t seed);
+
+void mcts_free(MctsPlayer *player);
+
+// Starts over from a new board, discarding what was searched
+void mcts_set_root(MctsPlayer *player, const Tile tiles[playfield_size][playfield_size]);
+
+// Keeps the subtree below swap_index as the new tree, with tiles as the board that swap led to
+void mcts_advance(MctsPlayer *player, int swap_index, const Tile tiles[playfield_size][playfield_size]);
+
+// Searches until time_limit seconds have passed and returns the most visited swap, or -1 if no
+// swap can score. The trees are kept, so calling it again continues the same search.
+int mcts_search(MctsPlayer *player, double time_limit);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+#include "zobrist.h"
+
+// Refill runs as a stage of its own once tiles have settled: the empty tiles, all at the top of
+// their columns, are gathered, a policy draws kinds for all of them at once, and they are
+// written back. Policies are plain structs with a draw_refill_kinds overload, picked by type
+// when refill_tiles is instantiated, so nothing is called indirectly per tile.
+
+// Every kind equally likely, drawn from the same stream and in the same order as
+// random_tile_kind would, column by column and top to bottom
+struct UniformRefill {
+    Random *random;
+};
+
+// Like uniform, except that some tiles copy the kind of the topmost settled tile in their
+// column. Pairs and near pairs are what swaps complete, so this keeps boards from running out
+// of moves.
+struct AntiDeadlockRefill {
+    Random *random;
+};
+
+// Chance out of 256 for AntiDeadlockRefill to copy a kind
+const auto anti_deadlock_bias = 64;
+
+// Kinds taken in order from a fixed sequence, starting over at its end, for tutorials and
+// reproducing reported boards
+struct ScriptedRefill {
+    const int *kinds;
+    int kind_count;
+
+    int next;
+};
+
+// The stream is stepped for every tile first, and then turned into kinds in a separate loop
+// without dependencies between tiles, which the compiler can vectorize
+static inline void draw_random_kinds(Random *random, int kinds[], int count) {
+    uint32_t values[playfield_size * playfield_size];
+
+    auto state = random->state;
+
+    for(auto i = 0; i < count; i += 1) {
+        state = step_random_state(state);
+        values[i] = state;
+    }
+
+    random->state = state;
+
+    for(auto i = 0; i < count; i += 1) {
+        kinds[i] = tile_kind_from_random(values[i]);
+    }
+}
+
+static inline void draw_refill_kinds(UniformRefill *policy, const Tile [playfield_size][playfield_size], const int [], int count, int kinds[]) {
+    draw_random_kinds(policy->random, kinds, count);
+}
+
+static inline void draw_refill_kinds(AntiDeadlockRefill *policy, const Tile tiles[playfield_size][playfield_size], const int cells[], int count, int kinds[]) {
+    draw_random_kinds(policy->random, kinds, count);
+
+    uint32_t values[playfield_size * playfield_size];
+
+    for(auto i = 0; i < count; i += 1) {
+        values[i] = next_random(policy->random);
+    }
+
+    for(auto i = 0; i < count; i += 1) {
+        auto x = cells[i] % playfield_size;
+
+        // Gaps are gathered top to bottom, so the tile below a column's last gap is its top one
+        auto top_y = cells[i] / playfield_size + 1;
+        while(top_y < playfield_size && tiles[top_y][x] == 0) {
+            top_y += 1;
+        }
+
+        if(top_y < playfield_size && (values[i] & 0xFF) < anti_deadlock_bias) {
+            kinds[i] = tiles[top_y][x];
+        }
+    }
+}
+
+static inline void draw_refill_kinds(ScriptedRefill *policy, const Tile [playfield_size][playfield_size], const int [], int count, int kinds[]) {
+    for(auto i = 0; i < count; i += 1) {
+        kinds[i] = policy->kinds[policy->next];
+
+        policy->next += 1;
+        if(policy->next == policy->kind_count) {
+            policy->next = 0;
+        }
+    }
+}
+
+// Fills every empty tile of a settled board and returns how many there were
+template <typename Policy>
+int refill_tiles(Tile tiles[playfield_size][playfield_size], Policy *policy, uint64_t *hash = nullptr) {
+    int cells[playfield_size * playfield_size];
+    auto count = 0;
+
+    for(auto x = 0; x < playfield_size; x += 1) {
+        for(auto y = 0; y < playfield_size && tiles[y][x] == 0; y += 1) {
+            cells[count] = y * playfield_size + x;
+            count += 1;
+        }
+    }
+
+    if(count == 0) {
+        return 0;
+    }
+
+    int kinds[playfield_size * playfield_size];
+    draw_refill_kinds(policy, tiles, cells, count, kinds);
+
+    for(auto i = 0; i < count; i += 1) {
+        auto x = cells[i] % playfield_size;
+        auto y = cells[i] / playfield_size;
+
+        tiles[y][x] = kinds[i];
+
+        if(hash != nullptr) {
+            *hash ^= zobrist_key(x, y, kinds[i]);
+        }
+    }
+
+    return count;
+}
+
+// The settle stage and whole swaps with any policy, picked at compile time like refill_tiles,
+// so rollouts and searches can play with any of them. With policy null the gaps are left.
+template <typename Policy>
+void settle_tiles(Tile tiles[playfield_size][playfield_size], Policy *policy, uint64_t *hash = nullptr) {
+    drop_tiles(tiles, hash);
+
+    if(policy != nullptr) {
+        refill_tiles(tiles, policy, hash);
+    }
+}
+
+// What a swap clears is up to a rule, another plain struct with two overloads: clear_swap_matches
+// makes the swap and clears whatever it completes, and clear_settled_matches clears whatever
+// settling lined up. Both return how many tiles they cleared, which is also the points.
+struct GroupRule {};
+
+static inline int clear_swap_matches(GroupRule *, Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash) {
+    return clear_swap_groups(tiles, swap_index, hash);
+}
+
+// Groups only ever clear through the swapped tiles, so settling never sets off more
+static inline int clear_settled_matches(GroupRule *, Tile [playfield_size][playfield_size], uint64_t *) {
+    return 0;
+}
+
+// Clears, settles and refills, over and over for as long as the rule finds more to clear
+template <typename Rule, typename Policy>
+int resolve_swap(Rule *rule, Tile tiles[playfield_size][playfield_size], Policy *policy, int swap_index, uint64_t *hash = nullptr) {
+    auto points = clear_swap_matches(rule, tiles, swap_index, hash);
+
+    auto cleared = points;
+    while(cleared != 0) {
+        settle_tiles(tiles, policy, hash);
+
+        cleared = clear_settled_matches(rule, tiles, hash);
+        points += cleared;
+    }
+
+    return points;
+}
+
+template <typename Policy>
+int simulate_swap(Tile tiles[playfield_size][playfield_size], Policy *policy, int swap_index, uint64_t *hash = nullptr) {
+    GroupRule rule;
+
+    return resolve_swap(&rule, tiles, policy, swap_index, hash);
+}
@@ -0,0 +1,371 @@
+#include "rules.h"
+#include <string.h>
+#include "zobrist.h"
+#include "refill.h"
+#include "bordered.h"
+
+void seed_random(Random *random, uint32_t seed) {
+    random->state = seed * 2654435761u;
+
+    if(random->state == 0) {
+        random->state = 1;
+    }
+}
+
+uint32_t next_random(Random *random) {
+    random->state = step_random_state(random->state);
+
+    return random->state;
+}
+
+int random_tile_kind(Random *random) {
+    return tile_kind_from_random(next_random(random));
+}
+
+int count_neighbours(const Tile tiles[playfield_size][playfield_size], bool counted[playfield_size][playfield_size], int x, int y, int kind) {
+    counted[y][x] = true;
+
+    auto total = 1;
+
+    if(in_playfield(x + 1, y) && tiles[y][x + 1] == kind && !counted[y][x + 1]) {
+        total += count_neighbours(tiles, counted, x + 1, y, kind);
+    }
+
+    if(in_playfield(x, y + 1) && tiles[y + 1][x] == kind && !counted[y + 1][x]) {
+        total += count_neighbours(tiles, counted, x, y + 1, kind);
+    }
+
+    if(in_playfield(x - 1, y) && tiles[y][x - 1] == kind && !counted[y][x - 1]) {
+        total += count_neighbours(tiles, counted, x - 1, y, kind);
+    }
+
+    if(in_playfield(x, y - 1) && tiles[y - 1][x] == kind && !counted[y - 1][x]) {
+        total += count_neighbours(tiles, counted, x, y - 1, kind);
+    }
+
+    return total;
+}
+
+void clear_neighbours(Tile tiles[playfield_size][playfield_size], int x, int y, int kind, uint64_t *hash) {
+    tiles[y][x] = 0;
+
+    if(hash != nullptr) {
+        *hash ^= zobrist_key(x, y, kind);
+    }
+
+    if(in_playfield(x + 1, y) && tiles[y][x + 1] == kind) {
+        clear_neighbours(tiles, x + 1, y, kind, hash);
+    }
+
+    if(in_playfield(x, y + 1) && tiles[y + 1][x] == kind) {
+        clear_neighbours(tiles, x, y + 1, kind, hash);
+    }
+
+    if(in_playfield(x - 1, y) && tiles[y][x - 1] == kind) {
+        clear_neighbours(tiles, x - 1, y, kind, hash);
+    }
+
+    if(in_playfield(x, y - 1) && tiles[y - 1][x] == kind) {
+        clear_neighbours(tiles, x, y - 1, kind, hash);
+    }
+}
+
+// A group reaches 3 tiles exactly when the tile has two same-kind neighbours, or its only
+// same-kind neighbour has another one. Written without data-dependent branches until the
+// rare single-neighbour case, since tile kinds are effectively random.
+bool in_group(const Tile tiles[playfield_size][playfield_size], int x, int y) {
+    auto kind = tiles[y][x];
+
+    if(kind == 0) {
+        return false;
+    }
+
+    auto right = (int)(x + 1 < playfield_size && tiles[y][x + 1] == kind);
+    auto below = (int)(y + 1 < playfield_size && tiles[y + 1][x] == kind);
+    auto left = (int)(x > 0 && tiles[y][x - 1] == kind);
+    auto above = (int)(y > 0 && tiles[y - 1][x] == kind);
+
+    auto count = right + below + left + above;
+
+    if(count != 1) {
+        return count >= 2;
+    }
+
+    auto neighbour_x = x + right - left;
+    auto neighbour_y = y + below - above;
+
+    auto neighbour_count =
+        (int)(neighbour_x + 1 < playfield_size && tiles[neighbour_y][neighbour_x + 1] == kind) +
+        (int)(neighbour_y + 1 < playfield_size && tiles[neighbour_y + 1][neighbour_x] == kind) +
+        (int)(neighbour_x > 0 && tiles[neighbour_y][neighbour_x - 1] == kind) +
+        (int)(neighbour_y > 0 && tiles[neighbour_y - 1][neighbour_x] == kind);
+
+    return neighbour_count >= 2;
+}
+
+bool swap_scores(Tile tiles[playfield_size][playfield_size], int swap_index) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from_tile_type = tiles[from_y][from_x];
+    auto to_tile_type = tiles[to_y][to_x];
+
+    // Gaps only exist with refill off, and a tile swapped into one would be left floating
+    if(from_tile_type == 0 || to_tile_type == 0) {
+        return false;
+    }
+
+    tiles[from_y][from_x] = to_tile_type;
+    tiles[to_y][to_x] = from_tile_type;
+
+    auto scores = in_group(tiles, to_x, to_y) | in_group(tiles, from_x, from_y);
+
+    tiles[from_y][from_x] = from_tile_type;
+    tiles[to_y][to_x] = to_tile_type;
+
+    return scores;
+}
+
+int swap_points(Tile tiles[playfield_size][playfield_size], int swap_index) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from_tile_type = tiles[from_y][from_x];
+    auto to_tile_type = tiles[to_y][to_x];
+
+    tiles[from_y][from_x] = to_tile_type;
+    tiles[to_y][to_x] = from_tile_type;
+
+    bool counted[playfield_size][playfield_size] {};
+
+    auto points = 0;
+
+    // Swapping into an empty tile, which only happens when refill is off, leaves nothing to count there
+    if(from_tile_type != 0) {
+        auto to_count = count_neighbours(tiles, counted, to_x, to_y, from_tile_type);
+
+        if(to_count >= 3) {
+            points += to_count;
+        }
+    }
+
+    if(to_tile_type != 0 && from_tile_type != to_tile_type) {
+        auto from_count = count_neighbours(tiles, counted, from_x, from_y, to_tile_type);
+
+        if(from_count >= 3) {
+            points += from_count;
+        }
+    }
+
+    tiles[from_y][from_x] = from_tile_type;
+    tiles[to_y][to_x] = to_tile_type;
+
+    return points;
+}
+
+int find_scoring_swaps(Tile tiles[playfield_size][playfield_size], int swap_indices[swap_count]) {
+    auto count = 0;
+
+    for(auto i = 0; i < swap_count; i += 1) {
+        if(swap_scores(tiles, i)) {
+            swap_indices[count] = i;
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+// Collects the group around (x, y) into cells, as y * playfield_size + x. Tiles count as visited
+// when they hold the current stamp, so nothing has to be cleared between swaps.
+static int collect_group(const Tile tiles[playfield_size][playfield_size], int visited[playfield_size][playfield_size], int stamp, int x, int y, int cells[], int cell_count) {
+    auto kind = tiles[y][x];
+
+    visited[y][x] = stamp;
+    cells[cell_count] = y * playfield_size + x;
+    cell_count += 1;
+
+    for(auto i = cell_count - 1; i < cell_count; i += 1) {
+        auto cell_x = cells[i] % playfield_size;
+        auto cell_y = cells[i] / playfield_size;
+
+        const int offsets[4][2] { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+
+        for(auto j = 0; j < 4; j += 1) {
+            auto neighbour_x = cell_x + offsets[j][0];
+            auto neighbour_y = cell_y + offsets[j][1];
+
+            if(in_playfield(neighbour_x, neighbour_y) && tiles[neighbour_y][neighbour_x] == kind && visited[neighbour_y][neighbour_x] != stamp) {
+                visited[neighbour_y][neighbour_x] = stamp;
+                cells[cell_count] = neighbour_y * playfield_size + neighbour_x;
+                cell_count += 1;
+            }
+        }
+    }
+
+    return cell_count;
+}
+
+// Each swap only visits the groups it forms, so the whole map costs time in proportion to the
+// board rather than to the board times the number of swaps
+void mark_potential_groups(Tile tiles[playfield_size][playfield_size], const int swap_indices[], int swap_index_count, bool potential[playfield_size][playfield_size]) {
+    memset(potential, 0, sizeof(bool) * playfield_size * playfield_size);
+
+    int visited[playfield_size][playfield_size] {};
+
+    for(auto i = 0; i < swap_index_count; i += 1) {
+        int from_x;
+        int from_y;
+        int to_x;
+        int to_y;
+        swap_from_index(swap_indices[i], &from_x, &from_y, &to_x, &to_y);
+
+        auto from_tile_type = tiles[from_y][from_x];
+        auto to_tile_type = tiles[to_y][to_x];
+
+        tiles[from_y][from_x] = to_tile_type;
+        tiles[to_y][to_x] = from_tile_type;
+
+        int cells[playfield_size * playfield_size];
+        auto cell_count = 0;
+
+        auto stamp = i + 1;
+
+        if(in_group(tiles, to_x, to_y)) {
+            cell_count = collect_group(tiles, visited, stamp, to_x, to_y, cells, cell_count);
+        }
+
+        if(in_group(tiles, from_x, from_y) && visited[from_y][from_x] != stamp) {
+            cell_count = collect_group(tiles, visited, stamp, from_x, from_y, cells, cell_count);
+        }
+
+        tiles[from_y][from_x] = from_tile_type;
+        tiles[to_y][to_x] = to_tile_type;
+
+        auto from_cell = from_y * playfield_size + from_x;
+        auto to_cell = to_y * playfield_size + to_x;
+
+        for(auto j = 0; j < cell_count; j += 1) {
+            auto cell = cells[j];
+
+            // The swapped tiles joined their groups from the other end of the swap
+            if(cell == from_cell) {
+                cell = to_cell;
+            } else if(cell == to_cell) {
+                cell = from_cell;
+            }
+
+            potential[cell / playfield_size][cell % playfield_size] = true;
+        }
+    }
+}
+
+void fill_random_tiles(Tile tiles[playfield_size][playfield_size], Random *random) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            tiles[y][x] = random_tile_kind(random);
+        }
+    }
+}
+
+void drop_tiles(Tile tiles[playfield_size][playfield_size], uint64_t *hash) {
+    for(auto x = 0; x < playfield_size; x += 1) {
+        auto space_count = 0;
+
+        for(auto offset_y = 0; offset_y <= playfield_size - 1; offset_y += 1) {
+            auto y = playfield_size - 1 - offset_y;
+
+            auto kind = tiles[y][x];
+
+            if(kind == 0) {
+                space_count += 1;
+            } else if(space_count > 0) {
+                tiles[y + space_count][x] = kind;
+                tiles[y][x] = 0;
+
+                if(hash != nullptr) {
+                    *hash ^= zobrist_key(x, y, kind) ^ zobrist_key(x, y + space_count, kind);
+                }
+            }
+        }
+    }
+}
+
+int clear_swap_groups(Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash) {
+    int from_x;
+    int from_y;
+    int to_x;
+    int to_y;
+    swap_from_index(swap_index, &from_x, &from_y, &to_x, &to_y);
+
+    auto from_tile_type = tiles[from_y][from_x];
+    auto to_tile_type = tiles[to_y][to_x];
+
+    tiles[from_y][from_x] = to_tile_type;
+    tiles[to_y][to_x] = from_tile_type;
+
+    if(hash != nullptr) {
+        *hash ^= zobrist_key(from_x, from_y, from_tile_type) ^ zobrist_key(to_x, to_y, to_tile_type);
+        *hash ^= zobrist_key(from_x, from_y, to_tile_type) ^ zobrist_key(to_x, to_y, from_tile_type);
+    }
+
+    // Groups are collected on a bordered copy, where the flood fill needs no bounds checks
+    BorderedTiles bordered;
+    bordered_load(&bordered, tiles);
+
+    bool visited[bordered_cell_count] {};
+    int group[playfield_size * playfield_size];
+
+    auto points = 0;
+
+    auto to = bordered_index(to_x, to_y);
+    auto from = bordered_index(from_x, from_y);
+
+    for(auto side = 0; side < 2; side += 1) {
+        auto start = side == 0 ? to : from;
+        auto kind = side == 0 ? from_tile_type : to_tile_type;
+
+        if(kind == 0 || visited[start]) {
+            continue;
+        }
+
+        auto count = bordered_collect_group(bordered.cells, visited, start, kind, group, 0);
+
+        if(count < 3) {
+            continue;
+        }
+
+        points += count;
+
+        for(auto i = 0; i < count; i += 1) {
+            auto x = group[i] % bordered_width - 1;
+            auto y = group[i] / bordered_width - 1;
+
+            tiles[y][x] = 0;
+
+            if(hash != nullptr) {
+                *hash ^= zobrist_key(x, y, kind);
+            }
+        }
+    }
+
+    return points;
+}
+
+void settle_tiles(Tile tiles[playfield_size][playfield_size], Random *random, uint64_t *hash) {
+    UniformRefill refill { random };
+
+    settle_tiles(tiles, random != nullptr ? &refill : nullptr, hash);
+}
+
+int simulate_swap(Tile tiles[playfield_size][playfield_size], Random *random, int swap_index, uint64_t *hash) {
+    UniformRefill refill { random };
+
+    return simulate_swap(tiles, random != nullptr ? &refill : nullptr, swap_index, hash);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+const int tile_kind_count = 6;
+
+const auto playfield_size = 10;
+
+// Tiles hold a kind from 1 to tile_kind_count, or 0 when empty, so a byte each is plenty and
+// keeps boards and search nodes 4 times smaller than ints would
+typedef uint8_t Tile;
+
+static inline bool in_playfield(int x, int y) {
+    return x >= 0 && y >= 0 && x < playfield_size && y < playfield_size;
+}
+
+struct Random {
+    uint32_t state;
+};
+
+static inline uint32_t step_random_state(uint32_t state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+void seed_random(Random *random, uint32_t seed);
+
+uint32_t next_random(Random *random);
+
+int random_tile_kind(Random *random);
+
+static inline int tile_kind_from_random(uint32_t value) {
+    return 1 + (int)(((value >> 16) * tile_kind_count) >> 16);
+}
+
+// Swaps are numbered with every horizontal pair first (row by row), then every vertical pair
+const auto horizontal_swap_count = playfield_size * (playfield_size - 1);
+const auto swap_count = horizontal_swap_count * 2;
+
+static inline void swap_from_index(int index, int *from_x, int *from_y, int *to_x, int *to_y) {
+    if(index < horizontal_swap_count) {
+        *from_x = index % (playfield_size - 1);
+        *from_y = index / (playfield_size - 1);
+        *to_x = *from_x + 1;
+        *to_y = *from_y;
+    } else {
+        auto vertical_index = index - horizontal_swap_count;
+
+        *from_x = vertical_index % playfield_size;
+        *from_y = vertical_index / playfield_size;
+        *to_x = *from_x;
+        *to_y = *from_y + 1;
+    }
+}
+
+// The swap between two neighbouring tiles, given either way round
+static inline int swap_index_between(int from_x, int from_y, int to_x, int to_y) {
+    auto x = from_x < to_x ? from_x : to_x;
+    auto y = from_y < to_y ? from_y : to_y;
+
+    if(from_y == to_y) {
+        return y * (playfield_size - 1) + x;
+    }
+
+    return horizontal_swap_count + y * playfield_size + x;
+}
+
+int count_neighbours(const Tile tiles[playfield_size][playfield_size], bool counted[playfield_size][playfield_size], int x, int y, int kind);
+
+// Functions that change tiles keep *hash, the board's Zobrist hash, up to date when given one
+void clear_neighbours(Tile tiles[playfield_size][playfield_size], int x, int y, int kind, uint64_t *hash = nullptr);
+
+// Whether the tile at (x, y) belongs to a group of 3 or more, decided from its neighbourhood alone
+bool in_group(const Tile tiles[playfield_size][playfield_size], int x, int y);
+
+bool swap_scores(Tile tiles[playfield_size][playfield_size], int swap_index);
+
+// Points a swap would score, without applying it
+int swap_points(Tile tiles[playfield_size][playfield_size], int swap_index);
+
+// Move generator: writes every swap that completes a group and returns how many there are
+int find_scoring_swaps(Tile tiles[playfield_size][playfield_size], int swap_indices[swap_count]);
+
+// Marks every tile that one of swap_indices, as found by find_scoring_swaps, would bring into a
+// group of 3 or more. Tiles are marked where they are before swapping.
+void mark_potential_groups(Tile tiles[playfield_size][playfield_size], const int swap_indices[], int swap_index_count, bool potential[playfield_size][playfield_size]);
+
+void fill_random_tiles(Tile tiles[playfield_size][playfield_size], Random *random);
+
+// Drops tiles into the gaps below them, leaving the gaps at the top of each column
+void drop_tiles(Tile tiles[playfield_size][playfield_size], uint64_t *hash = nullptr);
+
+// Makes the swap and clears the groups it completes, without settling, and returns the points
+int clear_swap_groups(Tile tiles[playfield_size][playfield_size], int swap_index, uint64_t *hash = nullptr);
+
+// Drops tiles and refills the gaps from random, or leaves them when random is null. Any refill
+// policy can be used through the templates in refill.h, of which these are the uniform one.
+void settle_tiles(Tile tiles[playfield_size][playfield_size], Random *random, uint64_t *hash = nullptr);
+
+int simulate_swap(Tile tiles[playfield_size][playfield_size], Random *random, int swap_index, uint64_t *hash = nullptr);
@@ -0,0 +1,101 @@
+#include "snapshot.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SNAPSHOT_SSE2
+#include <emmintrin.h>
+#endif
+
+// Tiles are packed 8 to a 64 bit load, or a whole word to an SSE2 register: each pair of
+// neighbouring tile bytes is merged into one byte with a shift and an or, and the merged bytes
+// gathered. Words and loads are little endian, as on every target the game builds for.
+
+const auto cell_count = playfield_size * playfield_size;
+
+// Merges 8 tiles, one per byte, into 32 bits of nibbles
+static inline uint32_t pack_8_tiles(uint64_t bytes) {
+    bytes = (bytes | bytes >> 4) & 0x00FF00FF00FF00FF;
+    bytes = (bytes | bytes >> 8) & 0x0000FFFF0000FFFF;
+
+    return (uint32_t)(bytes | bytes >> 16);
+}
+
+static inline uint64_t unpack_8_tiles(uint32_t nibbles) {
+    uint64_t bytes = nibbles;
+
+    bytes = (bytes | bytes << 16) & 0x0000FFFF0000FFFF;
+    bytes = (bytes | bytes << 8) & 0x00FF00FF00FF00FF;
+
+    return (bytes | bytes << 4) & 0x0F0F0F0F0F0F0F0F;
+}
+
+void pack_tiles(const Tile tiles[playfield_size][playfield_size], PackedTiles *packed) {
+    auto cells = &tiles[0][0];
+
+    auto start = 0;
+
+#if defined(SNAPSHOT_SSE2)
+    auto low_bytes = _mm_set1_epi16(0x00FF);
+
+    for(; start + packed_tiles_per_word <= cell_count; start += packed_tiles_per_word) {
+        auto bytes = _mm_loadu_si128((const __m128i*)(cells + start));
+
+        auto merged = _mm_and_si128(_mm_or_si128(bytes, _mm_srli_epi16(bytes, 4)), low_bytes);
+
+        _mm_storel_epi64((__m128i*)&packed->words[start / packed_tiles_per_word], _mm_packus_epi16(merged, merged));
+    }
+#else
+    for(; start + packed_tiles_per_word <= cell_count; start += packed_tiles_per_word) {
+        uint64_t low;
+        uint64_t high;
+        memcpy(&low, cells + start, 8);
+        memcpy(&high, cells + start + 8, 8);
+
+        packed->words[start / packed_tiles_per_word] = pack_8_tiles(low) | (uint64_t)pack_8_tiles(high) << 32;
+    }
+#endif
+
+    if(start < cell_count) {
+        uint64_t bytes[2] {};
+        memcpy(bytes, cells + start, cell_count - start);
+
+        packed->words[start / packed_tiles_per_word] = pack_8_tiles(bytes[0]) | (uint64_t)pack_8_tiles(bytes[1]) << 32;
+    }
+}
+
+void unpack_tiles(const PackedTiles *packed, Tile tiles[playfield_size][playfield_size]) {
+    auto cells = &tiles[0][0];
+
+    auto start = 0;
+
+#if defined(SNAPSHOT_SSE2)
+    auto low_nibbles = _mm_set1_epi16(0x000F);
+    auto high_nibbles = _mm_set1_epi16(0x00F0);
+
+    for(; start + packed_tiles_per_word <= cell_count; start += packed_tiles_per_word) {
+        auto merged = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&packed->words[start / packed_tiles_per_word]), _mm_setzero_si128());
+
+        auto bytes = _mm_or_si128(_mm_and_si128(merged, low_nibbles), _mm_slli_epi16(_mm_and_si128(merged, high_nibbles), 4));
+
+        _mm_storeu_si128((__m128i*)(cells + start), bytes);
+    }
+#else
+    for(; start + packed_tiles_per_word <= cell_count; start += packed_tiles_per_word) {
+        auto word = packed->words[start / packed_tiles_per_word];
+
+        auto low = unpack_8_tiles((uint32_t)word);
+        auto high = unpack_8_tiles((uint32_t)(word >> 32));
+
+        memcpy(cells + start, &low, 8);
+        memcpy(cells + start + 8, &high, 8);
+    }
+#endif
+
+    if(start < cell_count) {
+        auto word = packed->words[start / packed_tiles_per_word];
+
+        uint64_t bytes[2] { unpack_8_tiles((uint32_t)word), unpack_8_tiles((uint32_t)(word >> 32)) };
+
+        memcpy(cells + start, bytes, cell_count - start);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+const auto packed_tiles_per_word = 16;
+const auto packed_word_count = (playfield_size * playfield_size + packed_tiles_per_word - 1) / packed_tiles_per_word;
+
+static_assert(tile_kind_count < 16, "Tile kinds must fit in 4 bits");
+
+// A board at 4 bits per tile, row by row, which is small enough to copy by value
+struct PackedTiles {
+    uint64_t words[packed_word_count];
+};
+
+void pack_tiles(const Tile tiles[playfield_size][playfield_size], PackedTiles *packed);
+
+void unpack_tiles(const PackedTiles *packed, Tile tiles[playfield_size][playfield_size]);
+
+static inline int packed_tile(const PackedTiles *packed, int x, int y) {
+    auto index = y * playfield_size + x;
+
+    return (int)((packed->words[index / packed_tiles_per_word] >> (index % packed_tiles_per_word * 4)) & 0xF);
+}
+
+// Everything needed to carry on a game from a settled board: restoring the random state as
+// well means the same swaps bring the same refills.
+struct BoardSnapshot {
+    PackedTiles tiles;
+    uint64_t hash;
+
+    Random random;
+
+    int points;
+};
+
+static inline void take_snapshot(BoardSnapshot *snapshot, const Tile tiles[playfield_size][playfield_size], uint64_t hash, Random random, int points) {
+    pack_tiles(tiles, &snapshot->tiles);
+
+    snapshot->hash = hash;
+    snapshot->random = random;
+    snapshot->points = points;
+}
+
+static inline void restore_snapshot(const BoardSnapshot *snapshot, Tile tiles[playfield_size][playfield_size], uint64_t *hash, Random *random, int *points) {
+    unpack_tiles(&snapshot->tiles, tiles);
+
+    *hash = snapshot->hash;
+    *random = snapshot->random;
+    *points = snapshot->points;
+}
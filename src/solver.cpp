@@ -0,0 +1,376 @@
+#include "solver.h"
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "canonical.h"
+#include "zobrist.h"
+
+struct SolverValue {
+    int points;
+
+    // Whether points is the best the subtree can score, rather than only a bound on it
+    bool exact;
+};
+
+struct SolverRoot {
+    int swap_index;
+    int points;
+
+    SolverValue value;
+};
+
+struct SolverShared {
+    const Random *refill;
+    TranspositionTable *table;
+
+    // Points of the best line found so far in this iteration. Subtrees that cannot beat it are
+    // cut off, which only ever loosens their value into a bound.
+    std::atomic<int> best_points;
+
+    std::atomic<int> next_root;
+
+    const std::atomic<bool> *cancelled;
+};
+
+static bool search_cancelled(SolverShared *shared) {
+    return shared->cancelled != nullptr && shared->cancelled->load(std::memory_order_relaxed);
+}
+
+struct SolverThread {
+    SolverShared *shared;
+
+    long long nodes;
+    TranspositionStats stats;
+};
+
+static void raise_best_points(std::atomic<int> *best_points, int points) {
+    auto current = best_points->load(std::memory_order_relaxed);
+
+    while(points > current && !best_points->compare_exchange_weak(current, points, std::memory_order_relaxed)) {
+    }
+}
+
+// Without refill tiles are only ever taken away, so the rest of a line cannot score more than the
+// tiles of every kind that still has enough for a group, nor more per swap than the two largest
+// such kinds. With refill any tiles can fall in, and only the size of the playfield is a limit.
+static int points_bound(const Tile tiles[playfield_size][playfield_size], bool refill, int depth) {
+    if(refill) {
+        return depth * playfield_size * playfield_size;
+    }
+
+    int kind_counts[tile_kind_count + 1] {};
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            kind_counts[tiles[y][x]] += 1;
+        }
+    }
+
+    auto total = 0;
+    auto largest = 0;
+    auto second_largest = 0;
+
+    for(auto kind = 1; kind <= tile_kind_count; kind += 1) {
+        auto count = kind_counts[kind];
+
+        if(count < 3) {
+            continue;
+        }
+
+        total += count;
+
+        if(count > largest) {
+            second_largest = largest;
+            largest = count;
+        } else if(count > second_largest) {
+            second_largest = count;
+        }
+    }
+
+    auto per_swap = depth * (largest + second_largest);
+
+    return per_swap < total ? per_swap : total;
+}
+
+// Orders swaps by the points they score straight away, which finds good lines early and so lets
+// more of the rest be cut off
+static void order_swaps(Tile tiles[playfield_size][playfield_size], int swap_indices[], int points[], int count, int first_swap) {
+    for(auto i = 0; i < count; i += 1) {
+        points[i] = swap_points(tiles, swap_indices[i]);
+
+        auto order = swap_indices[i] == first_swap ? playfield_size * playfield_size * 2 : points[i];
+
+        auto j = i;
+        while(j > 0) {
+            auto other_order = swap_indices[j - 1] == first_swap ? playfield_size * playfield_size * 2 : points[j - 1];
+
+            if(other_order >= order) {
+                break;
+            }
+
+            auto swap_index = swap_indices[j];
+            swap_indices[j] = swap_indices[j - 1];
+            swap_indices[j - 1] = swap_index;
+
+            auto other_points = points[j];
+            points[j] = points[j - 1];
+            points[j - 1] = other_points;
+
+            j -= 1;
+        }
+    }
+}
+
+static SolverValue search(SolverThread *thread, Tile tiles[playfield_size][playfield_size], uint64_t hash, const Random *random, int depth, int line_points) {
+    auto shared = thread->shared;
+
+    thread->nodes += 1;
+
+    if(search_cancelled(shared)) {
+        return { 0, false };
+    }
+
+    if(depth == 0) {
+        raise_best_points(&shared->best_points, line_points);
+
+        return { 0, true };
+    }
+
+    auto bound = points_bound(tiles, random != nullptr, depth);
+
+    // Without refill, boards that are mirrors or relabellings of each other share their entry
+    auto key = hash;
+    auto mirrored = false;
+
+    if(random == nullptr) {
+        CanonicalBoard canonical;
+        canonicalize(tiles, &canonical);
+
+        key = canonical.hash;
+        mirrored = canonical.mirrored;
+    } else {
+        key ^= zobrist_random_key(*random);
+    }
+
+    auto first_swap = -1;
+
+    TranspositionEntry entry;
+    if(shared->table != nullptr && transposition_probe(shared->table, key, &entry, &thread->stats)) {
+        if(entry.bound == Bound::Exact && entry.depth == depth) {
+            raise_best_points(&shared->best_points, line_points + entry.value);
+
+            return { entry.value, true };
+        }
+
+        // More swaps never score less, so a value from a deeper search still bounds this one
+        if(entry.bound != Bound::Lower && entry.depth >= depth && entry.value < bound) {
+            bound = entry.value;
+        }
+
+        if(entry.move != -1) {
+            first_swap = mirrored ? mirror_swap_index(entry.move) : entry.move;
+        }
+    }
+
+    if(line_points + bound <= shared->best_points.load(std::memory_order_relaxed)) {
+        return { bound, false };
+    }
+
+    int swap_indices[swap_count];
+    auto swap_index_count = find_scoring_swaps(tiles, swap_indices);
+
+    if(swap_index_count == 0) {
+        raise_best_points(&shared->best_points, line_points);
+
+        return { 0, true };
+    }
+
+    int points[swap_count];
+    order_swaps(tiles, swap_indices, points, swap_index_count, first_swap);
+
+    auto best_exact = -1;
+    auto best_swap = -1;
+    auto best_bound = -1;
+
+    for(auto i = 0; i < swap_index_count; i += 1) {
+        Tile child_tiles[playfield_size][playfield_size];
+        memcpy(child_tiles, tiles, sizeof(child_tiles));
+
+        auto child_hash = hash;
+
+        Random child_random;
+        Random *child_random_pointer = nullptr;
+
+        if(random != nullptr) {
+            child_random = *random;
+            child_random_pointer = &child_random;
+        }
+
+        simulate_swap(child_tiles, child_random_pointer, swap_indices[i], &child_hash);
+
+        auto value = search(thread, child_tiles, child_hash, child_random_pointer, depth - 1, line_points + points[i]);
+        auto total = points[i] + value.points;
+
+        if(value.exact) {
+            if(total > best_exact) {
+                best_exact = total;
+                best_swap = swap_indices[i];
+            }
+        } else if(total > best_bound) {
+            best_bound = total;
+        }
+    }
+
+    // Cut off swaps were only bounded, so the best is only known when none of them could beat it
+    SolverValue value;
+    value.exact = best_exact >= best_bound;
+    value.points = value.exact ? best_exact : best_bound;
+
+    // Values below a cancelled search are meaningless, and must not end up in the table
+    if(shared->table != nullptr && !search_cancelled(shared)) {
+        auto move = best_swap;
+        if(move != -1 && mirrored) {
+            move = mirror_swap_index(move);
+        }
+
+        transposition_store(shared->table, key, { value.points, move, depth, value.exact ? Bound::Exact : Bound::Upper }, &thread->stats);
+    }
+
+    return value;
+}
+
+static void search_roots(SolverThread *thread, const Tile tiles[playfield_size][playfield_size], SolverRoot *roots, int root_count, int depth) {
+    auto shared = thread->shared;
+
+    while(true) {
+        auto index = shared->next_root.fetch_add(1);
+
+        if(index >= root_count) {
+            break;
+        }
+
+        auto root = &roots[index];
+
+        Tile child_tiles[playfield_size][playfield_size];
+        memcpy(child_tiles, tiles, sizeof(child_tiles));
+
+        uint64_t child_hash = hash_tiles(child_tiles);
+
+        Random child_random;
+        Random *child_random_pointer = nullptr;
+
+        if(shared->refill != nullptr) {
+            child_random = *shared->refill;
+            child_random_pointer = &child_random;
+        }
+
+        thread->nodes += 1;
+
+        simulate_swap(child_tiles, child_random_pointer, root->swap_index, &child_hash);
+
+        root->value = search(thread, child_tiles, child_hash, child_random_pointer, depth - 1, root->points);
+        root->value.points += root->points;
+    }
+}
+
+void solve_best_points(const Tile tiles[playfield_size][playfield_size], const Random *refill, int depth, int thread_count, TranspositionTable *table, SolverResult *result, const std::atomic<bool> *cancelled) {
+    result->points = 0;
+    result->swap_index = -1;
+    result->nodes = 1;
+    result->stats = {};
+
+    Tile root_tiles[playfield_size][playfield_size];
+    memcpy(root_tiles, tiles, sizeof(root_tiles));
+
+    int swap_indices[swap_count];
+    auto root_count = find_scoring_swaps(root_tiles, swap_indices);
+
+    if(root_count == 0 || depth <= 0) {
+        return;
+    }
+
+    int points[swap_count];
+    order_swaps(root_tiles, swap_indices, points, root_count, -1);
+
+    SolverRoot roots[swap_count];
+
+    for(auto i = 0; i < root_count; i += 1) {
+        roots[i].swap_index = swap_indices[i];
+        roots[i].points = points[i];
+    }
+
+    SolverShared shared;
+    shared.refill = refill;
+    shared.table = table;
+    shared.cancelled = cancelled;
+
+    if(table != nullptr) {
+        transposition_new_search(table);
+    }
+
+    if(thread_count < 1) {
+        thread_count = 1;
+    }
+
+    auto threads = (SolverThread*)malloc(thread_count * sizeof(SolverThread));
+
+    for(auto i = 0; i < thread_count; i += 1) {
+        threads[i].shared = &shared;
+        threads[i].nodes = 0;
+        threads[i].stats = {};
+    }
+
+    auto workers = new std::thread[thread_count - 1];
+
+    // Each iteration starts from just below the previous one's best, which is still reachable
+    // with one more swap, so the line that reaches it is searched rather than cut off
+    auto best_points = 0;
+
+    for(auto iteration_depth = 1; iteration_depth <= depth; iteration_depth += 1) {
+        shared.best_points = best_points - 1;
+        shared.next_root = 0;
+
+        for(auto i = 1; i < thread_count; i += 1) {
+            workers[i - 1] = std::thread(search_roots, &threads[i], root_tiles, roots, root_count, iteration_depth);
+        }
+
+        search_roots(&threads[0], root_tiles, roots, root_count, iteration_depth);
+
+        for(auto i = 1; i < thread_count; i += 1) {
+            workers[i - 1].join();
+        }
+
+        if(search_cancelled(&shared)) {
+            break;
+        }
+
+        // The best root is always searched exactly, since only lines that cannot beat it are cut
+        // off. Sorting by value, stable so ties keep their order, puts it first next iteration.
+        for(auto i = 1; i < root_count; i += 1) {
+            auto root = roots[i];
+
+            auto j = i;
+            while(j > 0 && (!roots[j - 1].value.exact || roots[j - 1].value.points < root.value.points) && root.value.exact) {
+                roots[j] = roots[j - 1];
+                j -= 1;
+            }
+
+            roots[j] = root;
+        }
+
+        best_points = roots[0].value.points;
+
+        result->points = best_points;
+        result->swap_index = roots[0].swap_index;
+    }
+
+    delete[] workers;
+
+    for(auto i = 0; i < thread_count; i += 1) {
+        result->nodes += threads[i].nodes;
+        add_transposition_stats(&result->stats, &threads[i].stats);
+    }
+
+    free(threads);
+}
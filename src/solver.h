@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+#include "rules.h"
+#include "transposition.h"
+
+struct SolverResult {
+    int points;
+
+    // First swap of a line that scores points, or -1 if no swap scores
+    int swap_index;
+
+    long long nodes;
+    TranspositionStats stats;
+};
+
+// Finds the most points that depth swaps can score, searching every line of play.
+//
+// With refill null the gaps left by cleared groups stay empty, so a board smaller than the
+// playfield can be solved by leaving the tiles outside it empty. Otherwise the search refills
+// from copies of refill, making the upcoming tiles known in advance.
+//
+// The root swaps are shared out between thread_count threads, which share table as well.
+//
+// Depths are searched one after another, and setting *cancelled stops the search early with the
+// result of the last depth it finished.
+void solve_best_points(const Tile tiles[playfield_size][playfield_size], const Random *refill, int depth, int thread_count, TranspositionTable *table, SolverResult *result, const std::atomic<bool> *cancelled = nullptr);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+// A fixed size ring that one producer thread pushes to and one consumer thread pops from,
+// without locks. Each side only ever writes its own index, and reads the other's to see how far
+// it may go. Capacity must be a power of two.
+template <typename T, size_t capacity>
+struct SpscQueue {
+    static_assert((capacity & (capacity - 1)) == 0, "Capacity must be a power of two");
+
+    T elements[capacity];
+
+    // Kept on separate cache lines, so the two threads do not contend for one
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+template <typename T, size_t capacity>
+void spsc_init(SpscQueue<T, capacity> *queue) {
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+// Returns false, leaving the queue as it was, when it is full
+template <typename T, size_t capacity>
+bool spsc_push(SpscQueue<T, capacity> *queue, const T &element) {
+    auto tail = queue->tail.load(std::memory_order_relaxed);
+
+    if(tail - queue->head.load(std::memory_order_acquire) == capacity) {
+        return false;
+    }
+
+    queue->elements[tail & (capacity - 1)] = element;
+    queue->tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+// How many elements are in the queue, as seen from the producer, which can only be more than
+// there are by the time it returns
+template <typename T, size_t capacity>
+size_t spsc_count(SpscQueue<T, capacity> *queue) {
+    return queue->tail.load(std::memory_order_relaxed) - queue->head.load(std::memory_order_acquire);
+}
+
+// Returns false when there is nothing to pop
+template <typename T, size_t capacity>
+bool spsc_pop(SpscQueue<T, capacity> *queue, T *element) {
+    auto head = queue->head.load(std::memory_order_relaxed);
+
+    if(head == queue->tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    *element = queue->elements[head & (capacity - 1)];
+    queue->head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
@@ -0,0 +1,144 @@
+#include "transposition.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Packed entry layout, from the lowest bit:
+//     value        32 bits
+//     move + 1     16 bits, so no move packs as 0
+//     depth         8 bits
+//     bound         2 bits, never 0, which tells a stored entry from an empty slot
+//     generation    6 bits
+const auto generation_mask = 0x3F;
+
+static uint64_t pack_entry(TranspositionEntry entry, uint32_t generation) {
+    return
+        (uint64_t)(uint32_t)entry.value |
+        (uint64_t)(uint16_t)(entry.move + 1) << 32 |
+        (uint64_t)(uint8_t)entry.depth << 48 |
+        (uint64_t)entry.bound << 56 |
+        (uint64_t)(generation & generation_mask) << 58;
+}
+
+static TranspositionEntry unpack_entry(uint64_t data) {
+    TranspositionEntry entry;
+    entry.value = (int32_t)(uint32_t)data;
+    entry.move = (int)(uint16_t)(data >> 32) - 1;
+    entry.depth = (int)(uint8_t)(data >> 48);
+    entry.bound = (Bound)((data >> 56) & 3);
+
+    return entry;
+}
+
+static uint32_t data_generation(uint64_t data) {
+    return (uint32_t)(data >> 58);
+}
+
+void transposition_init(TranspositionTable *table, size_t size_in_bytes) {
+    size_t bucket_count = 1;
+    while(bucket_count * 2 * sizeof(TranspositionBucket) <= size_in_bytes) {
+        bucket_count *= 2;
+    }
+
+    table->bucket_count = bucket_count;
+    table->buckets = (TranspositionBucket*)calloc(bucket_count, sizeof(TranspositionBucket));
+    table->generation = 0;
+}
+
+void transposition_free(TranspositionTable *table) {
+    free(table->buckets);
+}
+
+void transposition_clear(TranspositionTable *table) {
+    memset((void*)table->buckets, 0, table->bucket_count * sizeof(TranspositionBucket));
+}
+
+void transposition_new_search(TranspositionTable *table) {
+    table->generation += 1;
+}
+
+bool transposition_probe(TranspositionTable *table, uint64_t key, TranspositionEntry *entry, TranspositionStats *stats) {
+    stats->probes += 1;
+
+    auto bucket = &table->buckets[key & (table->bucket_count - 1)];
+
+    for(auto i = 0; i < transposition_bucket_size; i += 1) {
+        auto slot = &bucket->slots[i];
+
+        auto data = slot->data.load(std::memory_order_relaxed);
+        auto check = slot->check.load(std::memory_order_relaxed);
+
+        if(data != 0 && (check ^ data) == key) {
+            *entry = unpack_entry(data);
+
+            stats->hits += 1;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// An existing entry for the same key is kept only when it was searched deeper in this search.
+// Otherwise the shallowest slot is replaced, where each search an entry is out of date counts
+// against it as much as 4 levels of depth.
+void transposition_store(TranspositionTable *table, uint64_t key, TranspositionEntry entry, TranspositionStats *stats) {
+    auto generation = table->generation.load(std::memory_order_relaxed);
+
+    auto bucket = &table->buckets[key & (table->bucket_count - 1)];
+
+    TranspositionSlot *replace = nullptr;
+    auto replace_worth = 0;
+
+    for(auto i = 0; i < transposition_bucket_size; i += 1) {
+        auto slot = &bucket->slots[i];
+
+        auto data = slot->data.load(std::memory_order_relaxed);
+        auto check = slot->check.load(std::memory_order_relaxed);
+
+        if(data == 0) {
+            replace = slot;
+
+            break;
+        }
+
+        auto age = (int)((generation - data_generation(data)) & generation_mask);
+        auto depth = (int)(uint8_t)(data >> 48);
+
+        if((check ^ data) == key) {
+            if(age == 0 && depth > entry.depth) {
+                return;
+            }
+
+            replace = slot;
+
+            break;
+        }
+
+        auto worth = depth - age * 4;
+
+        if(replace == nullptr || worth < replace_worth) {
+            replace = slot;
+            replace_worth = worth;
+        }
+    }
+
+    auto old_data = replace->data.load(std::memory_order_relaxed);
+    if(old_data != 0 && (replace->check.load(std::memory_order_relaxed) ^ old_data) != key) {
+        stats->replacements += 1;
+    }
+
+    auto data = pack_entry(entry, generation);
+
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+
+    stats->stores += 1;
+}
+
+void add_transposition_stats(TranspositionStats *total, const TranspositionStats *stats) {
+    total->probes += stats->probes;
+    total->hits += stats->hits;
+    total->stores += stats->stores;
+    total->replacements += stats->replacements;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+enum struct Bound : uint8_t {
+    Exact = 1,
+    Lower,
+    Upper
+};
+
+struct TranspositionEntry {
+    int32_t value;
+    int move;
+    int depth;
+    Bound bound;
+};
+
+// Kept by each search thread and summed afterwards, so counting never contends between threads
+struct TranspositionStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t replacements;
+};
+
+// Slots are written without locks: check holds the key xored with data, so a slot torn by two
+// threads storing at once no longer matches either key and simply reads as a miss.
+struct TranspositionSlot {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
+
+const auto transposition_bucket_size = 4;
+
+struct TranspositionBucket {
+    TranspositionSlot slots[transposition_bucket_size];
+};
+
+struct TranspositionTable {
+    size_t bucket_count;
+    TranspositionBucket *buckets;
+
+    std::atomic<uint32_t> generation;
+};
+
+// Rounds size_in_bytes down to a power of two number of buckets
+void transposition_init(TranspositionTable *table, size_t size_in_bytes);
+
+void transposition_free(TranspositionTable *table);
+
+void transposition_clear(TranspositionTable *table);
+
+// Marks existing entries as belonging to an earlier search, making them the first to be replaced
+void transposition_new_search(TranspositionTable *table);
+
+bool transposition_probe(TranspositionTable *table, uint64_t key, TranspositionEntry *entry, TranspositionStats *stats);
+
+void transposition_store(TranspositionTable *table, uint64_t key, TranspositionEntry entry, TranspositionStats *stats);
+
+void add_transposition_stats(TranspositionStats *total, const TranspositionStats *stats);
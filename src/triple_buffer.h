@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the newest of a stream of values from one writer thread to one reader thread, without
+// either ever waiting on the other. Of the three slots the writer fills one and the reader reads
+// another, and the third holds the value published last, which each side swaps for its own.
+template <typename T>
+struct TripleBuffer {
+    T slots[3];
+
+    // Slot published last, with triple_buffer_fresh set until the reader takes it
+    std::atomic<int> middle;
+
+    int back;
+    int front;
+};
+
+const int triple_buffer_fresh = 4;
+const int triple_buffer_index_mask = 3;
+
+template <typename T>
+void triple_buffer_init(TripleBuffer<T> *buffer) {
+    buffer->back = 0;
+    buffer->middle = 1;
+    buffer->front = 2;
+}
+
+// The slot for the writer to fill next
+template <typename T>
+T *triple_buffer_back(TripleBuffer<T> *buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+template <typename T>
+void triple_buffer_publish(TripleBuffer<T> *buffer) {
+    auto previous = buffer->middle.exchange(buffer->back | triple_buffer_fresh, std::memory_order_acq_rel);
+
+    buffer->back = previous & triple_buffer_index_mask;
+}
+
+// The newest published value, which stays valid and unchanged until the next call
+template <typename T>
+const T *triple_buffer_front(TripleBuffer<T> *buffer) {
+    if((buffer->middle.load(std::memory_order_relaxed) & triple_buffer_fresh) != 0) {
+        auto previous = buffer->middle.exchange(buffer->front, std::memory_order_acq_rel);
+
+        buffer->front = previous & triple_buffer_index_mask;
+    }
+
+    return &buffer->slots[buffer->front];
+}
@@ -0,0 +1,130 @@
+#include "tweens.h"
+#include <math.h>
+#include <stdlib.h>
+
+void tweens_init(Tweens *tweens, int capacity, double epoch) {
+    tweens->capacity = capacity;
+    tweens->slot_count = 0;
+    tweens->free_slots = {};
+    tweens->epoch = epoch;
+
+    tweens->start_times = (float*)malloc(capacity * sizeof(float));
+    tweens->inverse_durations = (float*)malloc(capacity * sizeof(float));
+    tweens->from = (float*)malloc(capacity * sizeof(float));
+    tweens->change = (float*)malloc(capacity * sizeof(float));
+    tweens->ease_1 = (float*)malloc(capacity * sizeof(float));
+    tweens->ease_2 = (float*)malloc(capacity * sizeof(float));
+    tweens->ease_3 = (float*)malloc(capacity * sizeof(float));
+    tweens->progress = (float*)malloc(capacity * sizeof(float));
+    tweens->values = (float*)malloc(capacity * sizeof(float));
+}
+
+void tweens_free(Tweens *tweens) {
+    free(tweens->start_times);
+    free(tweens->inverse_durations);
+    free(tweens->from);
+    free(tweens->change);
+    free(tweens->ease_1);
+    free(tweens->ease_2);
+    free(tweens->ease_3);
+    free(tweens->progress);
+    free(tweens->values);
+
+    free(tweens->free_slots.elements);
+}
+
+int tween_add(Tweens *tweens, double start_time, double duration, float from, float to, Easing easing) {
+    int tween;
+
+    if(tweens->free_slots.count != 0) {
+        tweens->free_slots.count -= 1;
+
+        tween = tweens->free_slots[tweens->free_slots.count];
+    } else if(tweens->slot_count < tweens->capacity) {
+        tween = tweens->slot_count;
+
+        tweens->slot_count += 1;
+    } else {
+        return -1;
+    }
+
+    // Tweens too short to see end as soon as they start
+    const auto shortest_duration = 1e-4;
+
+    tweens->start_times[tween] = (float)(start_time - tweens->epoch);
+    tweens->inverse_durations[tween] = (float)(1 / (duration > shortest_duration ? duration : shortest_duration));
+
+    tweens->from[tween] = from;
+    tweens->change[tween] = to - from;
+
+    float ease_1;
+    float ease_2;
+    float ease_3;
+
+    switch(easing) {
+        case Easing::Linear: ease_1 = 1; ease_2 = 0; ease_3 = 0; break;
+        case Easing::EaseIn: ease_1 = 0; ease_2 = 1; ease_3 = 0; break;
+        case Easing::EaseOut: ease_1 = 2; ease_2 = -1; ease_3 = 0; break;
+        case Easing::Smooth: ease_1 = 0; ease_2 = 3; ease_3 = -2; break;
+        default: abort();
+    }
+
+    tweens->ease_1[tween] = ease_1;
+    tweens->ease_2[tween] = ease_2;
+    tweens->ease_3[tween] = ease_3;
+
+    tweens->progress[tween] = 0;
+    tweens->values[tween] = from;
+
+    return tween;
+}
+
+void tween_release(Tweens *tweens, int tween) {
+    // Released slots are still advanced, harmlessly, until they are handed out again
+    append(&tweens->free_slots, tween);
+}
+
+// Floats keep 2 microseconds apart at this many seconds
+const auto rebase_interval = 16.0;
+
+void tweens_advance(Tweens *tweens, double time) {
+    if(time - tweens->epoch > rebase_interval) {
+        auto shift = (float)(time - tweens->epoch);
+
+        for(auto i = 0; i < tweens->slot_count; i += 1) {
+            tweens->start_times[i] -= shift;
+        }
+
+        tweens->epoch += shift;
+    }
+
+    auto now = (float)(time - tweens->epoch);
+
+    auto start_times = tweens->start_times;
+    auto inverse_durations = tweens->inverse_durations;
+    auto from = tweens->from;
+    auto change = tweens->change;
+    auto ease_1 = tweens->ease_1;
+    auto ease_2 = tweens->ease_2;
+    auto ease_3 = tweens->ease_3;
+    auto progress = tweens->progress;
+    auto values = tweens->values;
+
+    for(auto i = 0; i < tweens->slot_count; i += 1) {
+        auto t = (now - start_times[i]) * inverse_durations[i];
+
+        t = t < 0 ? 0 : t;
+        t = t > 1 ? 1 : t;
+
+        progress[i] = t;
+        values[i] = from[i] + change[i] * (t * (ease_1[i] + t * (ease_2[i] + t * ease_3[i])));
+    }
+}
+
+double tween_end_time(const Tweens *tweens, int tween) {
+    return tweens->epoch + tweens->start_times[tween] + 1 / tweens->inverse_durations[tween];
+}
+
+double fall_duration(float distance) {
+    return sqrt(2 * distance / fall_acceleration);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "list.h"
+
+// Animations are tweens: a value moving from one number to another over a set time, starting at
+// a set time. Sequences are tweens that start when earlier ones end, so nothing steps animations
+// frame by frame and they play the same at any frame rate.
+
+// Easings are cubics in the fraction of the tween that has passed, so every tween is advanced
+// by the same arithmetic
+enum struct Easing {
+    Linear,
+    EaseIn,
+    EaseOut,
+    Smooth
+};
+
+// Tweens are kept as separate arrays of each of their fields, indexed by slot, and advancing
+// them is one pass over all slots without branches, which the compiler vectorizes. Slots of
+// finished tweens stay as they are until released, so the owner can read the final value.
+struct Tweens {
+    int capacity;
+
+    // Slots below this have been handed out at some point, and are the ones advanced
+    int slot_count;
+
+    List<int> free_slots;
+
+    // Times are kept as floats in seconds from this, which advancing moves up to the present
+    // every so often, so they stay small enough for floats to hold them to a few microseconds
+    // however long the game runs
+    double epoch;
+
+    float *start_times;
+    float *inverse_durations;
+
+    float *from;
+    float *change;
+
+    float *ease_1;
+    float *ease_2;
+    float *ease_3;
+
+    // Results of the last advance
+    float *progress;
+    float *values;
+};
+
+void tweens_init(Tweens *tweens, int capacity, double epoch);
+
+void tweens_free(Tweens *tweens);
+
+// Returns the tween's slot, or -1 if all slots are taken. Until start_time the tween holds at
+// from, and after start_time + duration at to.
+int tween_add(Tweens *tweens, double start_time, double duration, float from, float to, Easing easing);
+
+void tween_release(Tweens *tweens, int tween);
+
+void tweens_advance(Tweens *tweens, double time);
+
+static inline float tween_value(const Tweens *tweens, int tween) {
+    return tweens->values[tween];
+}
+
+static inline bool tween_started(const Tweens *tweens, int tween) {
+    return tweens->progress[tween] > 0;
+}
+
+static inline bool tween_done(const Tweens *tweens, int tween) {
+    return tweens->progress[tween] >= 1;
+}
+
+// When the tween ends, for starting the next one of a sequence
+double tween_end_time(const Tweens *tweens, int tween);
+
+// Tiles fall from rest at a constant acceleration, in tiles per second squared
+const auto fall_acceleration = 100.0;
+
+// How long a fall of distance tiles takes, which with EaseIn matches falling from rest
+double fall_duration(float distance);
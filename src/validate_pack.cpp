@@ -0,0 +1,477 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "rules.h"
+#include "transposition.h"
+#include "solver.h"
+#include "generator.h"
+
+// Packs hold one board per line, as playfield_size * playfield_size kinds from '1' to '6' row by
+// row. Empty lines and lines starting with '#' are skipped. Validated packs keep each accepted
+// board followed by its metrics.
+
+static double get_seconds() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    return std::chrono::duration<double>(now).count();
+}
+
+struct Band {
+    int min;
+    int max;
+};
+
+struct PackSettings {
+    int depth;
+    int thread_count;
+
+    Band moves;
+    Band points;
+
+    // How many more points the best line scores than always taking the best single swap, which
+    // is how much a board rewards planning ahead
+    Band planning;
+};
+
+enum struct Verdict {
+    Accepted,
+    Malformed,
+    HasGroup,
+    NoMoves,
+    OutOfBand
+};
+
+struct PackBoard {
+    Tile tiles[playfield_size][playfield_size];
+
+    Verdict verdict;
+
+    int move_count;
+    int best_points;
+    int greedy_points;
+};
+
+// Boards are read, validated and written a window at a time, so memory stays the same however
+// large the pack is
+const auto window_size = 4096;
+
+const auto table_size = 32 << 20;
+
+static bool in_band(Band band, int value) {
+    return value >= band.min && value <= band.max;
+}
+
+static bool parse_board(const char *line, Tile tiles[playfield_size][playfield_size]) {
+    for(auto i = 0; i < playfield_size * playfield_size; i += 1) {
+        auto character = line[i];
+
+        if(character < '1' || character >= '1' + tile_kind_count) {
+            return false;
+        }
+
+        tiles[i / playfield_size][i % playfield_size] = character - '0';
+    }
+
+    auto end = line[playfield_size * playfield_size];
+
+    return end == 0 || end == '\n' || end == '\r' || end == ' ';
+}
+
+static void write_board(FILE *file, const Tile tiles[playfield_size][playfield_size]) {
+    char line[playfield_size * playfield_size + 1];
+
+    for(auto i = 0; i < playfield_size * playfield_size; i += 1) {
+        line[i] = (char)('0' + tiles[i / playfield_size][i % playfield_size]);
+    }
+
+    line[playfield_size * playfield_size] = 0;
+
+    fputs(line, file);
+}
+
+// Refill is left out, as curated boards are scored on the tiles they start with
+static int greedy_points(const Tile tiles[playfield_size][playfield_size], int depth) {
+    Tile greedy_tiles[playfield_size][playfield_size];
+    memcpy(greedy_tiles, tiles, sizeof(greedy_tiles));
+
+    auto total_points = 0;
+
+    for(auto move = 0; move < depth; move += 1) {
+        auto best_swap = -1;
+        auto best_points = 0;
+
+        for(auto i = 0; i < swap_count; i += 1) {
+            if(!swap_scores(greedy_tiles, i)) {
+                continue;
+            }
+
+            auto points = swap_points(greedy_tiles, i);
+
+            if(points > best_points) {
+                best_swap = i;
+                best_points = points;
+            }
+        }
+
+        if(best_swap == -1) {
+            break;
+        }
+
+        total_points += simulate_swap(greedy_tiles, nullptr, best_swap);
+    }
+
+    return total_points;
+}
+
+static void validate_board(PackBoard *board, const PackSettings *settings, TranspositionTable *table) {
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            if(in_group(board->tiles, x, y)) {
+                board->verdict = Verdict::HasGroup;
+
+                return;
+            }
+        }
+    }
+
+    int scoring_swaps[swap_count];
+    board->move_count = find_scoring_swaps(board->tiles, scoring_swaps);
+
+    if(board->move_count == 0) {
+        board->verdict = Verdict::NoMoves;
+
+        return;
+    }
+
+    SolverResult result;
+    solve_best_points(board->tiles, nullptr, settings->depth, 1, table, &result);
+
+    board->best_points = result.points;
+    board->greedy_points = greedy_points(board->tiles, settings->depth);
+
+    auto in_bands =
+        in_band(settings->moves, board->move_count) &&
+        in_band(settings->points, board->best_points) &&
+        in_band(settings->planning, board->best_points - board->greedy_points);
+
+    board->verdict = in_bands ? Verdict::Accepted : Verdict::OutOfBand;
+}
+
+// Workers claim boards one at a time from a shared counter, so a thread that drew cheap boards
+// simply takes more of them. Each has its own table, kept between windows, since canonical
+// entries stay valid from one board to the next.
+static void validate_boards(PackBoard *boards, int board_count, std::atomic<int> *next_board, const PackSettings *settings, TranspositionTable *table) {
+    while(true) {
+        auto index = next_board->fetch_add(1);
+
+        if(index >= board_count) {
+            break;
+        }
+
+        if(boards[index].verdict == Verdict::Malformed) {
+            continue;
+        }
+
+        validate_board(&boards[index], settings, table);
+    }
+}
+
+// Workers are started once for the whole pack and handed each window in turn, working on it
+// alongside the main thread
+struct ValidationPool {
+    std::mutex mutex;
+    std::condition_variable window_ready;
+    std::condition_variable window_done;
+
+    // Counts up with every window handed out
+    int window;
+    bool stopping;
+
+    // Workers still on the current window
+    int busy_count;
+
+    PackBoard *boards;
+    int board_count;
+    std::atomic<int> next_board;
+
+    const PackSettings *settings;
+};
+
+static void validation_worker(ValidationPool *pool, TranspositionTable *table) {
+    auto last_window = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+
+            while(!pool->stopping && pool->window == last_window) {
+                pool->window_ready.wait(lock);
+            }
+
+            if(pool->stopping) {
+                return;
+            }
+
+            last_window = pool->window;
+        }
+
+        validate_boards(pool->boards, pool->board_count, &pool->next_board, pool->settings, table);
+
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+
+            pool->busy_count -= 1;
+        }
+
+        pool->window_done.notify_one();
+    }
+}
+
+static int generate_pack(const char *path, int board_count, uint32_t seed, int move_count) {
+    auto file = fopen(path, "w");
+
+    if(file == nullptr) {
+        printf("could not open %s\n", path);
+
+        return 1;
+    }
+
+    Random random;
+    seed_random(&random, seed);
+
+    for(auto i = 0; i < board_count; i += 1) {
+        Tile tiles[playfield_size][playfield_size];
+        generate_tiles(tiles, &random, move_count);
+
+        write_board(file, tiles);
+        fputc('\n', file);
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+static int validate_pack(const char *input_path, const char *output_path, const PackSettings *settings) {
+    auto input = fopen(input_path, "r");
+
+    if(input == nullptr) {
+        printf("could not open %s\n", input_path);
+
+        return 1;
+    }
+
+    auto output = fopen(output_path, "w");
+
+    if(output == nullptr) {
+        printf("could not open %s\n", output_path);
+
+        fclose(input);
+
+        return 1;
+    }
+
+    fprintf(output, "# board moves best_points greedy_points (depth %d)\n", settings->depth);
+
+    auto boards = (PackBoard*)malloc(window_size * sizeof(PackBoard));
+
+    auto tables = (TranspositionTable*)malloc(settings->thread_count * sizeof(TranspositionTable));
+    for(auto i = 0; i < settings->thread_count; i += 1) {
+        transposition_init(&tables[i], table_size);
+    }
+
+    auto pool = new ValidationPool;
+    pool->window = 0;
+    pool->stopping = false;
+    pool->busy_count = 0;
+    pool->boards = boards;
+    pool->settings = settings;
+
+    auto threads = new std::thread[settings->thread_count - 1];
+
+    for(auto i = 1; i < settings->thread_count; i += 1) {
+        threads[i - 1] = std::thread(validation_worker, pool, &tables[i]);
+    }
+
+    long long verdict_counts[(int)Verdict::OutOfBand + 1] {};
+    long long total_count = 0;
+
+    auto start_time = get_seconds();
+
+    char line[1024];
+    auto input_done = false;
+
+    while(!input_done) {
+        auto board_count = 0;
+
+        while(board_count < window_size) {
+            if(fgets(line, sizeof(line), input) == nullptr) {
+                input_done = true;
+
+                break;
+            }
+
+            if(line[0] == '\n' || line[0] == '\r' || line[0] == '#') {
+                continue;
+            }
+
+            auto board = &boards[board_count];
+            board->verdict = parse_board(line, board->tiles) ? Verdict::Accepted : Verdict::Malformed;
+
+            board_count += 1;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+
+            pool->board_count = board_count;
+            pool->next_board = 0;
+            pool->busy_count = settings->thread_count - 1;
+            pool->window += 1;
+        }
+
+        pool->window_ready.notify_all();
+
+        validate_boards(boards, board_count, &pool->next_board, settings, &tables[0]);
+
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+
+            while(pool->busy_count != 0) {
+                pool->window_done.wait(lock);
+            }
+        }
+
+        for(auto i = 0; i < board_count; i += 1) {
+            auto board = &boards[i];
+
+            verdict_counts[(int)board->verdict] += 1;
+
+            if(board->verdict == Verdict::Accepted) {
+                write_board(output, board->tiles);
+                fprintf(output, " %d %d %d\n", board->move_count, board->best_points, board->greedy_points);
+            }
+        }
+
+        total_count += board_count;
+    }
+
+    auto seconds = get_seconds() - start_time;
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+
+        pool->stopping = true;
+    }
+
+    pool->window_ready.notify_all();
+
+    for(auto i = 1; i < settings->thread_count; i += 1) {
+        threads[i - 1].join();
+    }
+
+    delete[] threads;
+    delete pool;
+
+    for(auto i = 0; i < settings->thread_count; i += 1) {
+        transposition_free(&tables[i]);
+    }
+
+    free(tables);
+    free(boards);
+
+    fclose(input);
+    fclose(output);
+
+    printf("%lld boards in %.1f s, %.1f boards/s\n", total_count, seconds, total_count / seconds);
+    printf("    accepted     %lld\n", verdict_counts[(int)Verdict::Accepted]);
+    printf("    malformed    %lld\n", verdict_counts[(int)Verdict::Malformed]);
+    printf("    has group    %lld\n", verdict_counts[(int)Verdict::HasGroup]);
+    printf("    no moves     %lld\n", verdict_counts[(int)Verdict::NoMoves]);
+    printf("    out of band  %lld\n", verdict_counts[(int)Verdict::OutOfBand]);
+
+    return 0;
+}
+
+static void print_usage() {
+    printf("usage: validate_pack [options] input output\n");
+    printf("       validate_pack --generate count seed output\n");
+    printf("options:\n");
+    printf("    --depth k            swaps the best score is searched over (3)\n");
+    printf("    --threads n          worker threads (all cores)\n");
+    printf("    --moves min max      band for the number of scoring swaps\n");
+    printf("    --points min max     band for the best score in k swaps\n");
+    printf("    --planning min max   band for the best score minus the greedy score\n");
+}
+
+int main(int argument_count, const char *arguments[]) {
+    if(argument_count == 5 && strcmp(arguments[1], "--generate") == 0) {
+        const auto generated_move_count = 3;
+
+        return generate_pack(arguments[4], atoi(arguments[2]), (uint32_t)atoi(arguments[3]), generated_move_count);
+    }
+
+    PackSettings settings;
+    settings.depth = 3;
+    settings.thread_count = (int)std::thread::hardware_concurrency();
+    settings.moves = { 1, swap_count };
+    settings.points = { 0, 1 << 30 };
+    settings.planning = { 0, 1 << 30 };
+
+    const char *paths[2];
+    auto path_count = 0;
+
+    for(auto i = 1; i < argument_count; i += 1) {
+        auto argument = arguments[i];
+        auto remaining = argument_count - i - 1;
+
+        Band *band = nullptr;
+
+        if(strcmp(argument, "--moves") == 0) {
+            band = &settings.moves;
+        } else if(strcmp(argument, "--points") == 0) {
+            band = &settings.points;
+        } else if(strcmp(argument, "--planning") == 0) {
+            band = &settings.planning;
+        }
+
+        if(band != nullptr && remaining >= 2) {
+            band->min = atoi(arguments[i + 1]);
+            band->max = atoi(arguments[i + 2]);
+
+            i += 2;
+        } else if(strcmp(argument, "--depth") == 0 && remaining >= 1) {
+            settings.depth = atoi(arguments[i + 1]);
+
+            i += 1;
+        } else if(strcmp(argument, "--threads") == 0 && remaining >= 1) {
+            settings.thread_count = atoi(arguments[i + 1]);
+
+            i += 1;
+        } else if(argument[0] != '-' && path_count < 2) {
+            paths[path_count] = argument;
+            path_count += 1;
+        } else {
+            print_usage();
+
+            return 1;
+        }
+    }
+
+    if(path_count != 2 || settings.depth < 1) {
+        print_usage();
+
+        return 1;
+    }
+
+    if(settings.thread_count < 1) {
+        settings.thread_count = 1;
+    }
+
+    return validate_pack(paths[0], paths[1], &settings);
+}
@@ -0,0 +1,134 @@
+#include "visuals.h"
+#include <stdlib.h>
+
+template <typename T>
+static void components_init(Components<T> *components, int capacity) {
+    components->count = 0;
+
+    components->values = (T*)malloc(capacity * sizeof(T));
+    components->owners = (int*)malloc(capacity * sizeof(int));
+    components->slots = (int*)malloc(capacity * sizeof(int));
+
+    for(auto i = 0; i < capacity; i += 1) {
+        components->slots[i] = -1;
+    }
+}
+
+template <typename T>
+static void components_free(Components<T> *components) {
+    free(components->values);
+    free(components->owners);
+    free(components->slots);
+}
+
+void visuals_init(Visuals *visuals, int capacity) {
+    visuals->capacity = capacity;
+    visuals->index_count = 0;
+    visuals->free_indices = {};
+
+    visuals->generations = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+
+    components_init(&visuals->placements, capacity);
+    components_init(&visuals->appearances, capacity);
+    components_init(&visuals->lifetimes, capacity);
+    components_init(&visuals->settling, capacity);
+}
+
+void visuals_free(Visuals *visuals) {
+    free(visuals->generations);
+
+    free(visuals->free_indices.elements);
+
+    components_free(&visuals->placements);
+    components_free(&visuals->appearances);
+    components_free(&visuals->lifetimes);
+    components_free(&visuals->settling);
+}
+
+Entity visual_create(Visuals *visuals) {
+    int index;
+
+    if(visuals->free_indices.count != 0) {
+        visuals->free_indices.count -= 1;
+
+        index = visuals->free_indices[visuals->free_indices.count];
+    } else if(visuals->index_count < visuals->capacity) {
+        index = visuals->index_count;
+
+        visuals->generations[index] = 0;
+        visuals->index_count += 1;
+    } else {
+        return no_entity;
+    }
+
+    return { index, visuals->generations[index] };
+}
+
+void visual_destroy(Visuals *visuals, Tweens *tweens, Entity entity) {
+    if(!visual_alive(visuals, entity)) {
+        return;
+    }
+
+    auto index = entity.index;
+
+    auto placement = component_of(&visuals->placements, index);
+
+    if(placement != nullptr) {
+        int owned_tweens[] = { placement->x_tween, placement->y_tween, placement->scale_tween };
+
+        for(auto tween : owned_tweens) {
+            if(tween != -1) {
+                tween_release(tweens, tween);
+            }
+        }
+    }
+
+    component_remove(&visuals->placements, index);
+    component_remove(&visuals->appearances, index);
+    component_remove(&visuals->lifetimes, index);
+    component_remove(&visuals->settling, index);
+
+    visuals->generations[index] += 1;
+
+    append(&visuals->free_indices, index);
+}
+
+void place_visuals(Visuals *visuals, const Tweens *tweens) {
+    auto placements = visuals->placements.values;
+
+    for(auto i = 0; i < visuals->placements.count; i += 1) {
+        auto placement = &placements[i];
+
+        auto started = true;
+
+        if(placement->x_tween != -1) {
+            placement->x = tween_value(tweens, placement->x_tween);
+            started = started && tween_started(tweens, placement->x_tween);
+        }
+
+        if(placement->y_tween != -1) {
+            placement->y = tween_value(tweens, placement->y_tween);
+            started = started && tween_started(tweens, placement->y_tween);
+        }
+
+        if(placement->scale_tween != -1) {
+            placement->scale = tween_value(tweens, placement->scale_tween);
+            started = started && tween_started(tweens, placement->scale_tween);
+        }
+
+        placement->shown = started || !placement->wait_for_start;
+    }
+}
+
+void expire_visuals(Visuals *visuals, Tweens *tweens) {
+    auto lifetimes = &visuals->lifetimes;
+
+    // Backwards, as destroying moves the last lifetime into the place of the one destroyed
+    for(auto i = lifetimes->count - 1; i >= 0; i -= 1) {
+        if(tween_done(tweens, lifetimes->values[i].tween)) {
+            auto index = lifetimes->owners[i];
+
+            visual_destroy(visuals, tweens, { index, visuals->generations[index] });
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+#include "list.h"
+#include "rules.h"
+#include "tweens.h"
+
+// Everything drawn that comes and goes, such as clearing and falling tiles, particles and score
+// popups, is an entity with some set of components. Each kind of component is kept packed in an
+// array of its own, and each system is a pass over one of those arrays, so a new effect is new
+// entities rather than a new list with its own loops.
+
+// Handles name an entity by index and by the generation of that index, which goes up whenever
+// an entity there is destroyed, so a handle kept past its entity's end is told apart from one
+// to whatever took the index since
+struct Entity {
+    int index;
+    uint32_t generation;
+};
+
+const Entity no_entity = { -1, 0 };
+
+// Where the entity is, in tiles from the top left of the playfield, and how large. Coordinates
+// with a tween follow it, and the tweens belong to the entity, released when it is destroyed.
+struct Placement {
+    float x;
+    float y;
+    float scale;
+
+    int x_tween;
+    int y_tween;
+    int scale_tween;
+
+    // Entities made ahead of time, such as particles waiting for their turn in a sequence, are
+    // only shown once their tweens have started
+    bool wait_for_start;
+    bool shown;
+};
+
+enum struct VisualShape : uint8_t {
+    ShrinkingTile,
+    FullTile,
+    Particle,
+    Popup
+};
+
+// How the entity is drawn, with number the points shown by popups
+struct Appearance {
+    VisualShape shape;
+    Tile kind;
+
+    int number;
+};
+
+// The entity is destroyed once this tween, one of its own, is done
+struct Lifetime {
+    int tween;
+};
+
+// Entities that keep the board settling for as long as they last, and the cell each is on its
+// way into, which the board already holds and so is not drawn until they are gone
+struct Settling {
+    int x;
+    int y;
+};
+
+// A packed array of one kind of component, with where each entity's is, if it has one
+template <typename T>
+struct Components {
+    int count;
+
+    T *values;
+
+    // Index of the entity each value belongs to
+    int *owners;
+
+    // For each entity index, where its value is, or -1
+    int *slots;
+};
+
+struct Visuals {
+    int capacity;
+
+    // Indices below this have been handed out at some point
+    int index_count;
+
+    List<int> free_indices;
+
+    // Destroying an entity moves its index on a generation, so no handle matches a free index
+    uint32_t *generations;
+
+    Components<Placement> placements;
+    Components<Appearance> appearances;
+    Components<Lifetime> lifetimes;
+    Components<Settling> settling;
+};
+
+void visuals_init(Visuals *visuals, int capacity);
+
+void visuals_free(Visuals *visuals);
+
+// Returns no_entity when all capacity entities exist
+Entity visual_create(Visuals *visuals);
+
+// Releases the entity's tweens along with it. Stale handles are ignored.
+void visual_destroy(Visuals *visuals, Tweens *tweens, Entity entity);
+
+static inline bool visual_alive(const Visuals *visuals, Entity entity) {
+    return entity.index != -1 && visuals->generations[entity.index] == entity.generation;
+}
+
+template <typename T>
+void component_set(Components<T> *components, Entity entity, T value) {
+    auto slot = components->slots[entity.index];
+
+    if(slot == -1) {
+        slot = components->count;
+
+        components->owners[slot] = entity.index;
+        components->slots[entity.index] = slot;
+
+        components->count += 1;
+    }
+
+    components->values[slot] = value;
+}
+
+// Moves the last value into the removed one's place, which keeps the array packed
+template <typename T>
+void component_remove(Components<T> *components, int index) {
+    auto slot = components->slots[index];
+
+    if(slot == -1) {
+        return;
+    }
+
+    auto last = components->count - 1;
+
+    components->values[slot] = components->values[last];
+    components->owners[slot] = components->owners[last];
+    components->slots[components->owners[slot]] = slot;
+
+    components->slots[index] = -1;
+    components->count -= 1;
+}
+
+template <typename T>
+T *component_of(Components<T> *components, int index) {
+    auto slot = components->slots[index];
+
+    return slot == -1 ? nullptr : &components->values[slot];
+}
+
+// Systems, run once an update after the tweens have been advanced
+
+// Moves placements to where their tweens are
+void place_visuals(Visuals *visuals, const Tweens *tweens);
+
+// Destroys entities whose lifetime is up
+void expire_visuals(Visuals *visuals, Tweens *tweens);
@@ -0,0 +1,23 @@
+#include "zobrist.h"
+
+uint64_t zobrist_keys[playfield_size][playfield_size][tile_kind_count + 1];
+
+static bool initialize_zobrist_keys() {
+    uint64_t index = 0;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            zobrist_keys[y][x][0] = 0;
+
+            for(auto kind = 1; kind <= tile_kind_count; kind += 1) {
+                zobrist_keys[y][x][kind] = zobrist_mix(index);
+
+                index += 1;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool zobrist_keys_initialized = initialize_zobrist_keys();
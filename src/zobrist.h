@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "rules.h"
+
+// Filled in before main runs, from a fixed seed so that every run and thread agrees on them.
+// Empty tiles have no key.
+extern uint64_t zobrist_keys[playfield_size][playfield_size][tile_kind_count + 1];
+
+static inline uint64_t zobrist_mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+
+    return value ^ (value >> 31);
+}
+
+static inline uint64_t zobrist_key(int x, int y, int kind) {
+    return zobrist_keys[y][x][kind];
+}
+
+// For searches whose refill is deterministic, where the upcoming tiles are part of the position
+static inline uint64_t zobrist_random_key(Random random) {
+    return zobrist_mix(((uint64_t)1 << 32) | random.state);
+}
+
+static inline uint64_t hash_tiles(const Tile tiles[playfield_size][playfield_size]) {
+    uint64_t hash = 0;
+
+    for(auto y = 0; y < playfield_size; y += 1) {
+        for(auto x = 0; x < playfield_size; x += 1) {
+            hash ^= zobrist_key(x, y, tiles[y][x]);
+        }
+    }
+
+    return hash;
+}